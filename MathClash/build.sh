@@ -5,10 +5,10 @@ echo "Building..."
 
 # Use MSYS2 SFML paths (automatically in PATH)
 g++ -std=c++17 -O2 -I/ucrt64/include \
-    src/main.cpp \
+    src/main.cpp src/stats_shm.cpp src/password_hash.cpp src/questions.cpp \
     -o MathClashGame.exe \
     -L/ucrt64/lib \
-    -lsfml-graphics -lsfml-window -lsfml-system
+    -lsfml-graphics -lsfml-window -lsfml-system -pthread
 
 if [ $? -eq 0 ]; then
     echo "✅ Build successful!"
@@ -16,6 +16,10 @@ if [ $? -eq 0 ]; then
     cp /ucrt64/bin/sfml-graphics-2.dll .
     cp /ucrt64/bin/sfml-window-2.dll .
     cp /ucrt64/bin/sfml-system-2.dll .
+    echo "📊 Building stats reader..."
+    g++ -std=c++17 -O2 src/stats_reader.cpp src/stats_shm.cpp -o MathClashStats.exe
+    echo "🧮 Building question verifier..."
+    g++ -std=c++17 -O2 src/verify_questions.cpp src/questions.cpp -o MathClashVerify.exe -pthread
     echo "🎮 Ready to run: ./MathClashGame.exe"
 else
     echo "❌ Build failed!"
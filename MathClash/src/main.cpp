@@ -4,32 +4,46 @@
 #include <fstream>
 #include <sstream>
 #include <cmath>
-#include <stack>
 #include <iomanip>
 #include <chrono>
 #include <cstdlib>
 #include <ctime>
 #include <limits>
 #include <algorithm>
-#include <list>
 #include <thread>
+#include <list>
+#include <string_view>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <filesystem>
+#include <iterator>
+#include <future>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <random>
+#include <unordered_map>
+#include <deque>
+#include <charconv>
+#include <numeric>
+#include <system_error>
 
 // SFML Graphics Library for game visuals
 #include <SFML/Graphics.hpp>
 #include <SFML/Window.hpp>
 #include <SFML/System.hpp>
 
+#include "password_hash.h"
+#include "questions.h"
+#include "stats_shm.h"
+
 using namespace std;
 using namespace sf;
 
 // Our game's building blocks - how we store questions and player info
-struct Question {
-    string expression;
-    double answer;
-    bool answered_correctly = false;
-    bool skipped = false;
-};
 
+// One player's record as read from users.txt, before it goes into UserTable
 struct User {
     string username;
     string password;
@@ -37,17 +51,979 @@ struct User {
     int games_played = 0;
     int games_won = 0;
     int games_lost = 0;
-    list<Question> failed_questions;
+    vector<PackedQuestion> failed_questions;
+    SeenFilter seen;
+};
+
+// Parts of a player's row that changed since the last save
+enum DirtyField : uint8_t {
+    DIRTY_NEW = 1 << 0,       // row is not in users.txt yet
+    DIRTY_SCORE = 1 << 1,
+    DIRTY_GAMES = 1 << 2,     // games played / won / lost
+    DIRTY_FAILED = 1 << 3,    // failed question list
+    DIRTY_SEEN = 1 << 4,      // recently asked question filter
+    DIRTY_PASSWORD = 1 << 5   // password rehashed on login
+};
+
+// Position of an interned string inside UserTable's arena
+struct ArenaString {
+    uint32_t offset = 0;
+    uint32_t length = 0;
+};
+
+// All registered players stored column by column (struct-of-arrays).
+// Scores and game counts live in their own contiguous vectors so the
+// leaderboard and save loops walk memory linearly, usernames and passwords
+// are interned into one shared character arena, and each player's failed
+// questions sit in a single contiguous slab instead of a linked list.
+struct UserTable {
+    vector<char> arena;
+    vector<ArenaString> interned;
+    vector<uint32_t> intern_slots;  // open addressing, stores interned index + 1
+    vector<uint32_t> name_slots;    // open addressing, stores row + 1
+
+    vector<ArenaString> usernames;
+    vector<ArenaString> passwords;
+    vector<int> total_score;
+    vector<int> games_played;
+    vector<int> games_won;
+    vector<int> games_lost;
+    vector<vector<PackedQuestion>> failed_questions;
+    vector<SeenFilter> seen_questions;
+
+    // Where each player's failed-question and seen-filter lines live in
+    // users.txt. Rows read from users.idx start with questions_loaded = 0
+    // and are paged in on login.
+    vector<uint64_t> body_offset;
+    vector<uint32_t> body_length;
+    vector<uint32_t> stored_failed_count;
+    vector<uint32_t> stored_seen_lines;
+    vector<uint8_t> questions_loaded;
+
+    // Fields changed since the last save (DirtyField bits) and the rows
+    // that have any, so saving never has to scan every player
+    vector<uint8_t> dirty;
+    vector<uint32_t> dirty_rows;
+    // Questions added to seen filters since the last save, in order;
+    // journaled one by one instead of rewriting the whole filter
+    vector<pair<uint32_t, PackedQuestion>> seen_inserts;
+
+    size_t size() const { return usernames.size(); }
+
+    string_view view(ArenaString s) const {
+        return string_view(arena.data() + s.offset, s.length);
+    }
+    string_view username(size_t i) const { return view(usernames[i]); }
+    string_view password(size_t i) const { return view(passwords[i]); }
+
+    // Store a string once; identical strings share the same arena bytes
+    ArenaString intern(string_view text) {
+        if ((interned.size() + 1) * 2 > intern_slots.size()) {
+            grow_intern_slots();
+        }
+        size_t mask = intern_slots.size() - 1;
+        size_t slot = hash<string_view>()(text) & mask;
+        while (intern_slots[slot] != 0) {
+            ArenaString existing = interned[intern_slots[slot] - 1];
+            if (view(existing) == text) return existing;
+            slot = (slot + 1) & mask;
+        }
+
+        ArenaString s{static_cast<uint32_t>(arena.size()), static_cast<uint32_t>(text.size())};
+        arena.insert(arena.end(), text.begin(), text.end());
+        interned.push_back(s);
+        intern_slots[slot] = static_cast<uint32_t>(interned.size());
+        return s;
+    }
+
+    void grow_intern_slots() {
+        size_t new_size = intern_slots.empty() ? 64 : intern_slots.size() * 2;
+        intern_slots.assign(new_size, 0);
+        size_t mask = new_size - 1;
+        for (size_t i = 0; i < interned.size(); ++i) {
+            size_t slot = hash<string_view>()(view(interned[i])) & mask;
+            while (intern_slots[slot] != 0) slot = (slot + 1) & mask;
+            intern_slots[slot] = static_cast<uint32_t>(i + 1);
+        }
+    }
+
+    void grow_name_slots() {
+        size_t new_size = name_slots.empty() ? 64 : name_slots.size() * 2;
+        name_slots.assign(new_size, 0);
+        size_t mask = new_size - 1;
+        for (size_t i = 0; i < usernames.size(); ++i) {
+            size_t slot = hash<string_view>()(username(i)) & mask;
+            while (name_slots[slot] != 0) slot = (slot + 1) & mask;
+            name_slots[slot] = static_cast<uint32_t>(i + 1);
+        }
+    }
+
+    // Returns the row of a player, or -1 when the name is unknown
+    int find(string_view name) const {
+        if (name_slots.empty()) return -1;
+        size_t mask = name_slots.size() - 1;
+        size_t slot = hash<string_view>()(name) & mask;
+        while (name_slots[slot] != 0) {
+            uint32_t row = name_slots[slot] - 1;
+            if (username(row) == name) return static_cast<int>(row);
+            slot = (slot + 1) & mask;
+        }
+        return -1;
+    }
+
+    size_t add(string_view name, string_view pass) {
+        if ((usernames.size() + 1) * 2 > name_slots.size()) {
+            grow_name_slots();
+        }
+        size_t mask = name_slots.size() - 1;
+        size_t slot = hash<string_view>()(name) & mask;
+        while (name_slots[slot] != 0) slot = (slot + 1) & mask;
+        name_slots[slot] = static_cast<uint32_t>(usernames.size() + 1);
+
+        usernames.push_back(intern(name));
+        passwords.push_back(intern(pass));
+        total_score.push_back(0);
+        games_played.push_back(0);
+        games_won.push_back(0);
+        games_lost.push_back(0);
+        failed_questions.emplace_back();
+        seen_questions.emplace_back();
+        body_offset.push_back(0);
+        body_length.push_back(0);
+        stored_failed_count.push_back(0);
+        stored_seen_lines.push_back(0);
+        questions_loaded.push_back(1);
+        dirty.push_back(0);
+        return size() - 1;
+    }
+
+    size_t add(User&& u) {
+        size_t i = add(u.username, u.password);
+        total_score[i] = u.total_score;
+        games_played[i] = u.games_played;
+        games_won[i] = u.games_won;
+        games_lost[i] = u.games_lost;
+        stored_failed_count[i] = static_cast<uint32_t>(u.failed_questions.size());
+        stored_seen_lines[i] = u.seen.empty() ? 0 : 1;
+        failed_questions[i] = move(u.failed_questions);
+        seen_questions[i] = move(u.seen);
+        return i;
+    }
+
+    void mark_dirty(size_t i, uint8_t fields) {
+        if (dirty[i] == 0) dirty_rows.push_back(static_cast<uint32_t>(i));
+        dirty[i] |= fields;
+    }
+
+    void clear_dirty() {
+        for (uint32_t row : dirty_rows) dirty[row] = 0;
+        dirty_rows.clear();
+        seen_inserts.clear();
+    }
+
+    size_t failed_count(size_t i) const {
+        return questions_loaded[i] ? failed_questions[i].size() : stored_failed_count[i];
+    }
+
+    double get_win_rate(size_t i) const {
+        if (games_played[i] == 0) return 0.0;
+        return (static_cast<double>(games_won[i]) / games_played[i]) * 100.0;
+    }
+
+    void clear() {
+        *this = UserTable();
+    }
 
-    double get_win_rate() const {
-        if (games_played == 0) return 0.0;
-        return (static_cast<double>(games_won) / games_played) * 100.0;
+    // The columns write_users_files() reads, without the lookup slots or
+    // dirty state, for saving on another thread
+    UserTable copy_for_saving() const {
+        UserTable copy;
+        copy.arena = arena;
+        copy.usernames = usernames;
+        copy.passwords = passwords;
+        copy.total_score = total_score;
+        copy.games_played = games_played;
+        copy.games_won = games_won;
+        copy.games_lost = games_lost;
+        copy.failed_questions = failed_questions;
+        copy.seen_questions = seen_questions;
+        copy.body_offset = body_offset;
+        copy.body_length = body_length;
+        copy.stored_failed_count = stored_failed_count;
+        copy.stored_seen_lines = stored_seen_lines;
+        copy.questions_loaded = questions_loaded;
+        return copy;
+    }
+
+    // Bytes held by the table, counting reserved capacity
+    size_t memory_usage() const {
+        size_t bytes = sizeof(*this);
+        bytes += arena.capacity();
+        bytes += interned.capacity() * sizeof(ArenaString);
+        bytes += (intern_slots.capacity() + name_slots.capacity()) * sizeof(uint32_t);
+        bytes += (usernames.capacity() + passwords.capacity()) * sizeof(ArenaString);
+        bytes += (total_score.capacity() + games_played.capacity() +
+                  games_won.capacity() + games_lost.capacity()) * sizeof(int);
+        bytes += failed_questions.capacity() * sizeof(vector<PackedQuestion>);
+        for (const auto& slab : failed_questions) {
+            bytes += slab.capacity() * sizeof(PackedQuestion);
+        }
+        bytes += seen_questions.capacity() * sizeof(SeenFilter);
+        for (const auto& filter : seen_questions) {
+            bytes += filter.words.capacity() * sizeof(uint64_t);
+        }
+        bytes += body_offset.capacity() * sizeof(uint64_t);
+        bytes += (body_length.capacity() + stored_failed_count.capacity() +
+                  stored_seen_lines.capacity()) * sizeof(uint32_t);
+        bytes += questions_loaded.capacity() + dirty.capacity();
+        bytes += dirty_rows.capacity() * sizeof(uint32_t);
+        bytes += seen_inserts.capacity() * sizeof(seen_inserts[0]);
+        return bytes;
+    }
+};
+
+const size_t LEADERBOARD_SIZE = 5;
+
+struct ScoreEntry {
+    int score;
+    uint32_t row;
+};
+
+// Higher score first; ties broken by row so every reader sees the same order
+bool ranks_higher(const ScoreEntry& a, const ScoreEntry& b) {
+    if (a.score != b.score) return a.score > b.score;
+    return a.row < b.row;
+}
+
+// Immutable top entries of one shard. Readers use it without locking; it
+// is only freed once no reader can still be looking at it.
+struct ShardSnapshot {
+    uint64_t version = 0;
+    size_t count = 0;
+    ScoreEntry top[LEADERBOARD_SIZE];
+};
+
+// Epoch-based reclamation for retired snapshots. A reader publishes the
+// epoch it started in; a snapshot retired at epoch R is freed once every
+// active reader started after R. Each shard keeps its own retired list
+// under its own lock, so writers only share the epoch counter.
+struct SnapshotEpochs {
+    static const int MAX_READERS = 128;
+
+    struct alignas(64) ReaderSlot {
+        atomic<uint64_t> epoch{0};   // 0 = not reading
+        atomic<bool> claimed{false};
+    };
+
+    using RetiredList = vector<pair<uint64_t, ShardSnapshot*>>;
+
+    atomic<uint64_t> global_epoch{1};
+    ReaderSlot slots[MAX_READERS];
+
+    // Each thread keeps one reader slot for its whole lifetime
+    int thread_slot() {
+        struct SlotOwner {
+            SnapshotEpochs* epochs;
+            int slot = -1;
+            ~SlotOwner() {
+                if (slot >= 0) epochs->slots[slot].claimed.store(false);
+            }
+        };
+        static thread_local SlotOwner owner{this};
+        while (owner.slot < 0) {
+            for (int i = 0; i < MAX_READERS; ++i) {
+                bool expected = false;
+                if (slots[i].claimed.compare_exchange_strong(expected, true)) {
+                    owner.slot = i;
+                    break;
+                }
+            }
+            if (owner.slot < 0) this_thread::yield();
+        }
+        return owner.slot;
+    }
+
+    void enter(int slot) {
+        slots[slot].epoch.store(global_epoch.load());
+    }
+
+    void exit(int slot) {
+        slots[slot].epoch.store(0, memory_order_release);
+    }
+
+    // Caller holds the lock that guards `retired`
+    void retire(RetiredList& retired, ShardSnapshot* snapshot) {
+        retired.push_back({global_epoch.fetch_add(1), snapshot});
+
+        uint64_t oldest_reader = numeric_limits<uint64_t>::max();
+        for (auto& slot : slots) {
+            uint64_t epoch = slot.epoch.load();
+            if (epoch != 0) oldest_reader = min(oldest_reader, epoch);
+        }
+
+        size_t kept = 0;
+        for (auto& entry : retired) {
+            if (entry.first < oldest_reader) delete entry.second;
+            else retired[kept++] = entry;
+        }
+        retired.resize(kept);
+    }
+};
+
+SnapshotEpochs snapshot_epochs;
+
+// Player scores split into shards by row. A writer only locks its own
+// shard and republishes that shard's top entries when they change;
+// leaderboard reads merge the published snapshots without taking locks.
+struct ShardedScoreStore {
+    static const size_t SHARD_COUNT = 16;
+
+    struct alignas(64) Shard {
+        mutex lock;
+        vector<int> scores;                 // indexed by row / SHARD_COUNT
+        ShardSnapshot working;              // writer's copy of the published top
+        atomic<ShardSnapshot*> published{nullptr};
+        SnapshotEpochs::RetiredList retired;   // replaced snapshots readers may still hold
+    };
+
+    Shard shards[SHARD_COUNT];
+
+    // No reader is left once the store goes away
+    ~ShardedScoreStore() {
+        for (auto& shard : shards) {
+            delete shard.published.load();
+            for (auto& entry : shard.retired) delete entry.second;
+        }
+    }
+
+    void set_score(uint32_t row, int score) {
+        Shard& shard = shards[row % SHARD_COUNT];
+        size_t local = row / SHARD_COUNT;
+        lock_guard<mutex> guard(shard.lock);
+        if (local >= shard.scores.size()) shard.scores.resize(local + 1, 0);
+        shard.scores[local] = score;
+        if (update_top(shard, row % SHARD_COUNT, {score, row})) publish(shard);
+    }
+
+    // Load every score at once, e.g. after reading users.txt
+    void rebuild(const vector<int>& scores) {
+        for (size_t s = 0; s < SHARD_COUNT; ++s) {
+            Shard& shard = shards[s];
+            lock_guard<mutex> guard(shard.lock);
+            shard.scores.clear();
+            for (size_t row = s; row < scores.size(); row += SHARD_COUNT) {
+                shard.scores.push_back(scores[row]);
+            }
+            rescan_top(shard, s);
+            publish(shard);
+        }
+    }
+
+    // Best `count` players across all shards, read without locking
+    vector<ScoreEntry> top(size_t count) {
+        ScoreEntry merged[SHARD_COUNT * LEADERBOARD_SIZE];
+        size_t total = 0;
+
+        int slot = snapshot_epochs.thread_slot();
+        snapshot_epochs.enter(slot);
+        for (auto& shard : shards) {
+            const ShardSnapshot* snapshot = shard.published.load();
+            if (!snapshot) continue;
+            for (size_t i = 0; i < snapshot->count; ++i) merged[total++] = snapshot->top[i];
+        }
+        snapshot_epochs.exit(slot);
+
+        count = min({count, total, LEADERBOARD_SIZE});
+        partial_sort(merged, merged + count, merged + total, ranks_higher);
+        return vector<ScoreEntry>(merged, merged + count);
+    }
+
+    // Keep shard.working in sync after one score change. Returns true if
+    // the visible top entries changed and need republishing.
+    bool update_top(Shard& shard, size_t shard_index, ScoreEntry entry) {
+        ShardSnapshot& top = shard.working;
+        size_t pos = 0;
+        while (pos < top.count && top.top[pos].row != entry.row) pos++;
+
+        if (pos < top.count) {
+            bool dropped = entry.score < top.top[pos].score;
+            top.top[pos] = entry;
+            if (dropped && top.count == LEADERBOARD_SIZE) {
+                // Someone outside the top may now beat this player
+                rescan_top(shard, shard_index);
+            } else {
+                sort(top.top, top.top + top.count, ranks_higher);
+            }
+            return true;
+        }
+
+        if (top.count == LEADERBOARD_SIZE && !ranks_higher(entry, top.top[top.count - 1])) {
+            return false;
+        }
+        if (top.count < LEADERBOARD_SIZE) top.count++;
+        top.top[top.count - 1] = entry;
+        sort(top.top, top.top + top.count, ranks_higher);
+        return true;
+    }
+
+    void rescan_top(Shard& shard, size_t shard_index) {
+        ShardSnapshot& top = shard.working;
+        top.count = 0;
+        for (size_t local = 0; local < shard.scores.size(); ++local) {
+            ScoreEntry entry{shard.scores[local], static_cast<uint32_t>(local * SHARD_COUNT + shard_index)};
+            if (top.count == LEADERBOARD_SIZE && !ranks_higher(entry, top.top[top.count - 1])) continue;
+            if (top.count < LEADERBOARD_SIZE) top.count++;
+            top.top[top.count - 1] = entry;
+            sort(top.top, top.top + top.count, ranks_higher);
+        }
+    }
+
+    void publish(Shard& shard) {
+        shard.working.version++;
+        ShardSnapshot* old = shard.published.exchange(new ShardSnapshot(shard.working));
+        if (old) snapshot_epochs.retire(shard.retired, old);
+    }
+};
+
+// Every player in leaderboard order, for scrolling the full All Time board.
+// Entries sit in sorted blocks of up to 2 * BLOCK_SIZE; finding a rank
+// walks the block sizes and then indexes one block, and a score change
+// shifts entries inside one or two blocks. A million players take about
+// 8 MB in some 1000 blocks, so a page costs a few microseconds.
+// Only the main thread touches it.
+struct RankIndex {
+    static const size_t BLOCK_SIZE = 1024;
+
+    vector<vector<ScoreEntry>> blocks;
+    vector<int> scores;          // by row: the score each entry is filed under
+    size_t count = 0;
+
+    size_t size() const { return count; }
+
+    void rebuild(const vector<int>& all_scores) {
+        scores = all_scores;
+        vector<ScoreEntry> sorted(scores.size());
+        for (size_t row = 0; row < scores.size(); ++row) sorted[row] = {scores[row], static_cast<uint32_t>(row)};
+        sort(sorted.begin(), sorted.end(), ranks_higher);
+
+        blocks.clear();
+        for (size_t first = 0; first < sorted.size(); first += BLOCK_SIZE) {
+            blocks.emplace_back(sorted.begin() + first, sorted.begin() + min(first + BLOCK_SIZE, sorted.size()));
+        }
+        count = sorted.size();
+    }
+
+    // New rows start at 0 points, as in the score store
+    void set_score(uint32_t row, int score) {
+        while (scores.size() <= row) {
+            scores.push_back(0);
+            insert({0, static_cast<uint32_t>(scores.size() - 1)});
+        }
+        if (scores[row] == score) return;
+        erase({scores[row], row});
+        scores[row] = score;
+        insert({score, row});
+    }
+
+    // Zero-based position of row on the board
+    size_t rank_of(uint32_t row) const {
+        ScoreEntry entry{scores[row], row};
+        size_t b = find_block(entry);
+        size_t rank = 0;
+        for (size_t i = 0; i < b; ++i) rank += blocks[i].size();
+        const auto& block = blocks[b];
+        return rank + (lower_bound(block.begin(), block.end(), entry, ranks_higher) - block.begin());
+    }
+
+    // Up to `limit` entries starting at rank `first`
+    vector<ScoreEntry> page(size_t first, size_t limit) const {
+        vector<ScoreEntry> out;
+        size_t b = 0;
+        while (b < blocks.size() && first >= blocks[b].size()) first -= blocks[b++].size();
+        for (; b < blocks.size() && out.size() < limit; ++b, first = 0) {
+            size_t take = min(blocks[b].size() - first, limit - out.size());
+            out.insert(out.end(), blocks[b].begin() + first, blocks[b].begin() + first + take);
+        }
+        return out;
+    }
+
+    // First block whose last entry does not rank above entry
+    size_t find_block(const ScoreEntry& entry) const {
+        size_t lo = 0, hi = blocks.size();
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (ranks_higher(blocks[mid].back(), entry)) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    void insert(const ScoreEntry& entry) {
+        count++;
+        if (blocks.empty()) {
+            blocks.push_back({entry});
+            return;
+        }
+        size_t b = min(find_block(entry), blocks.size() - 1);
+        auto& block = blocks[b];
+        block.insert(lower_bound(block.begin(), block.end(), entry, ranks_higher), entry);
+        if (block.size() >= 2 * BLOCK_SIZE) {
+            vector<ScoreEntry> upper(block.begin() + BLOCK_SIZE, block.end());
+            block.resize(BLOCK_SIZE);
+            blocks.insert(blocks.begin() + b + 1, move(upper));
+        }
+    }
+
+    void erase(const ScoreEntry& entry) {
+        size_t b = find_block(entry);
+        auto& block = blocks[b];
+        block.erase(lower_bound(block.begin(), block.end(), entry, ranks_higher));
+        // Fold a shrinking block into its neighbour so blocks stay large
+        if (b + 1 < blocks.size() && block.size() + blocks[b + 1].size() <= BLOCK_SIZE) {
+            block.insert(block.end(), blocks[b + 1].begin(), blocks[b + 1].end());
+            blocks.erase(blocks.begin() + b + 1);
+        }
+        if (block.empty()) blocks.erase(blocks.begin() + b);
+        count--;
     }
 };
 
 // Game-wide variables that track everything happening
-vector<User> all_users;
-User current_user;
+UserTable all_users;
+ShardedScoreStore score_store;
+RankIndex rank_index;
+
+static_assert(STATS_TOP_N <= LEADERBOARD_SIZE, "score store keeps too few leaders for the stats export");
+
+// Longest username sign-up accepts, so every new name fits the stats export
+const size_t MAX_USERNAME_LENGTH = STATS_NAME_BYTES;
+
+// Publishes the leaderboard and per-player counters into shared memory
+// (stats_shm.h) so external tools can read them without parsing users.txt
+struct StatsExport {
+    StatsSegment* segment = nullptr;
+
+    void open() {
+        segment = stats_create_segment();
+        if (!segment) {
+            cerr << "Could not create the shared stats segment\n";
+            return;
+        }
+        // The segment may be left over from a game that crashed while
+        // writing; reset every counter before tools are let back in
+        segment->magic = 0;
+        for (auto& player : segment->players) player.seq.store(0, memory_order_relaxed);
+        segment->top_seq.store(0, memory_order_relaxed);
+        segment->player_count.store(0);
+        segment->top_count.store(0);
+        segment->capacity = STATS_MAX_PLAYERS;
+        segment->version = STATS_VERSION;
+        segment->magic = STATS_MAGIC;
+    }
+
+    void close() {
+        stats_close_segment(segment, true);
+        segment = nullptr;
+    }
+
+    void publish_player(size_t row) {
+        if (!segment || row >= segment->capacity) return;
+        StatsPlayer& player = segment->players[row];
+        string_view name = all_users.username(row);
+
+        stats_write_begin(player.seq);
+        player.username.store(name.data(), name.size());
+        player.total_score.store(all_users.total_score[row], memory_order_relaxed);
+        player.games_played.store(all_users.games_played[row], memory_order_relaxed);
+        player.games_won.store(all_users.games_won[row], memory_order_relaxed);
+        player.games_lost.store(all_users.games_lost[row], memory_order_relaxed);
+        player.failed_count.store(static_cast<uint32_t>(all_users.failed_count(row)), memory_order_relaxed);
+        stats_write_end(player.seq);
+
+        if (row >= segment->player_count.load(memory_order_relaxed)) {
+            segment->player_count.store(static_cast<uint32_t>(row + 1), memory_order_release);
+        }
+    }
+
+    void publish_top() {
+        if (!segment) return;
+        vector<ScoreEntry> leaders = score_store.top(STATS_TOP_N);
+
+        stats_write_begin(segment->top_seq);
+        for (size_t i = 0; i < leaders.size(); ++i) {
+            string_view name = all_users.username(leaders[i].row);
+            segment->top[i].username.store(name.data(), name.size());
+            segment->top[i].score.store(leaders[i].score, memory_order_relaxed);
+        }
+        segment->top_count.store(static_cast<uint32_t>(leaders.size()), memory_order_relaxed);
+        stats_write_end(segment->top_seq);
+    }
+
+    void publish_all() {
+        if (!segment) return;
+        segment->player_count.store(0, memory_order_release);
+        for (size_t row = 0; row < all_users.size(); ++row) publish_player(row);
+        publish_top();
+    }
+};
+
+StatsExport stats_export;
+
+// Score gained by each player during one time slice (an hour or a day),
+// plus that slice's best totals so a window query only merges small lists
+struct ScoreBucket {
+    static constexpr size_t TOP_K = 32;
+
+    int64_t id = -1;                         // hours or days since the epoch
+    unordered_map<uint32_t, int> totals;
+    vector<ScoreEntry> top;
+    bool top_stale = false;
+
+    const vector<ScoreEntry>& best() {
+        if (top_stale) {
+            top.clear();
+            for (auto& total : totals) top.push_back({total.second, total.first});
+            size_t keep = min(TOP_K, top.size());
+            partial_sort(top.begin(), top.begin() + keep, top.end(), ranks_higher);
+            top.resize(keep);
+            top_stale = false;
+        }
+        return top;
+    }
+};
+
+enum LeaderboardWindow {
+    ALL_TIME,
+    WEEKLY,
+    DAILY
+};
+
+// Rolling daily and weekly leaderboards fed by score-change events. The
+// last 24 hours live in hourly buckets and the last 7 days in daily ones;
+// a bucket that falls out of its window is reused for the new slice.
+struct WindowedLeaderboard {
+    struct Ring {
+        int64_t seconds_per_bucket;
+        vector<ScoreBucket> buckets;
+    };
+
+    Ring hours{3600, vector<ScoreBucket>(24)};
+    Ring days{86400, vector<ScoreBucket>(7)};
+
+    // Maps of rotated-out buckets, freed a few entries per frame by tick()
+    deque<unordered_map<uint32_t, int>> retiring;
+    unordered_map<uint32_t, int>::iterator retiring_next;
+    bool retiring_started = false;
+
+    // Last answer per window, reused until an event or rotation changes it
+    uint64_t version = 0;
+    uint64_t cached_version[3] = {~0ULL, ~0ULL, ~0ULL};
+    int64_t cached_bucket[3] = {-1, -1, -1};
+    vector<ScoreEntry> cached[3];
+
+    ScoreBucket& bucket_for(Ring& ring, int64_t id) {
+        ScoreBucket& bucket = ring.buckets[id % ring.buckets.size()];
+        if (bucket.id != id) {
+            if (!bucket.totals.empty()) {
+                retiring.emplace_back();
+                retiring.back().swap(bucket.totals);
+            }
+            bucket.id = id;
+            bucket.top.clear();
+            bucket.top_stale = false;
+            version++;
+        }
+        return bucket;
+    }
+
+    void record(uint32_t row, int delta, int64_t now) {
+        for (Ring* ring : {&hours, &days}) {
+            int64_t id = now / ring->seconds_per_bucket;
+            // Too old for this ring: its slot already holds a newer slice
+            if (ring->buckets[id % ring->buckets.size()].id > id) continue;
+            ScoreBucket& bucket = bucket_for(*ring, id);
+            bucket.totals[row] += delta;
+            bucket.top_stale = true;
+        }
+        version++;
+    }
+
+    // Spread the cost of dropping old buckets over many frames
+    void tick(int64_t now) {
+        bucket_for(hours, now / hours.seconds_per_bucket);
+        bucket_for(days, now / days.seconds_per_bucket);
+
+        size_t budget = 256;
+        while (budget > 0 && !retiring.empty()) {
+            auto& old = retiring.front();
+            if (!retiring_started) {
+                retiring_next = old.begin();
+                retiring_started = true;
+            }
+            while (budget > 0 && retiring_next != old.end()) {
+                retiring_next = old.erase(retiring_next);
+                budget--;
+            }
+            if (retiring_next == old.end()) {
+                retiring.pop_front();
+                retiring_started = false;
+            }
+        }
+    }
+
+    const vector<ScoreEntry>& top(LeaderboardWindow window, size_t count, int64_t now) {
+        Ring& ring = window == DAILY ? hours : days;
+        int64_t current = now / ring.seconds_per_bucket;
+        if (cached_version[window] == version && cached_bucket[window] == current) return cached[window];
+
+        int64_t oldest = current - static_cast<int64_t>(ring.buckets.size()) + 1;
+        vector<ScoreBucket*> live;
+        for (auto& bucket : ring.buckets) {
+            if (bucket.id >= oldest && bucket.id <= current) live.push_back(&bucket);
+        }
+
+        // Anyone in a bucket's top list is a candidate; sum their window total.
+        // A player outside every top list has at most `bound` points in the
+        // window, so the merged answer is exact when it beats that bound.
+        vector<uint32_t> candidates;
+        int64_t bound = 0;
+        bool any_full = false;
+        for (ScoreBucket* bucket : live) {
+            const vector<ScoreEntry>& best = bucket->best();
+            for (const auto& entry : best) candidates.push_back(entry.row);
+            if (bucket->totals.size() > best.size()) {
+                any_full = true;
+                bound += max(0, best.back().score);
+            }
+        }
+        sort(candidates.begin(), candidates.end());
+        candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+
+        vector<ScoreEntry> ranked;
+        for (uint32_t row : candidates) {
+            int total = 0;
+            for (ScoreBucket* bucket : live) {
+                auto it = bucket->totals.find(row);
+                if (it != bucket->totals.end()) total += it->second;
+            }
+            ranked.push_back({total, row});
+        }
+        size_t keep = min(count, ranked.size());
+        partial_sort(ranked.begin(), ranked.begin() + keep, ranked.end(), ranks_higher);
+        ranked.resize(keep);
+
+        if (any_full && (ranked.size() < count || ranked.back().score <= bound)) {
+            // Too many active players for the shortcut: add up every bucket
+            unordered_map<uint32_t, int> sums;
+            for (ScoreBucket* bucket : live) {
+                for (auto& total : bucket->totals) sums[total.first] += total.second;
+            }
+            ranked.clear();
+            for (auto& sum : sums) ranked.push_back({sum.second, sum.first});
+            keep = min(count, ranked.size());
+            partial_sort(ranked.begin(), ranked.begin() + keep, ranked.end(), ranks_higher);
+            ranked.resize(keep);
+        }
+
+        cached[window] = move(ranked);
+        cached_version[window] = version;
+        cached_bucket[window] = current;
+        return cached[window];
+    }
+};
+
+WindowedLeaderboard windowed_scores;
+
+// Open a line-per-record log for appending. A crash can leave the last
+// record without its newline; replay skips it, so it is cut off here
+// before the next record would be glued onto it.
+FILE* open_log_for_append(const char* path) {
+    ifstream in(path, ios::binary | ios::ate);
+    if (in.is_open()) {
+        streamoff size = in.tellg();
+        streamoff keep = size;
+        char c = 0;
+        while (keep > 0 && in.seekg(keep - 1) && in.get(c) && c != '\n') keep--;
+        in.close();
+        if (keep < size) {
+            error_code ec;
+            filesystem::resize_file(path, static_cast<uintmax_t>(keep), ec);
+            if (ec) return nullptr;
+        }
+    }
+    return fopen(path, "ab");
+}
+
+// Score changes are also appended to score_events.log ("time name delta")
+// so the daily and weekly boards survive a restart
+const char* SCORE_EVENTS_FILE = "score_events.log";
+const int64_t SCORE_EVENTS_KEEP_SECONDS = 7 * 86400;
+FILE* score_events = nullptr;
+
+void record_score_event(uint32_t row, int delta) {
+    int64_t now = static_cast<int64_t>(time(nullptr));
+    windowed_scores.record(row, delta, now);
+
+    if (!score_events) score_events = open_log_for_append(SCORE_EVENTS_FILE);
+    if (!score_events) return;
+    string_view name = all_users.username(row);
+    fprintf(score_events, "%lld %.*s %d\n", static_cast<long long>(now), static_cast<int>(name.size()),
+            name.data(), delta);
+    fflush(score_events);
+}
+
+// The logged-in player: just a row in all_users. Changes are written
+// straight into the table's columns and flagged as dirty for the next save.
+struct UserHandle {
+    int row = -1;
+
+    bool valid() const { return row >= 0; }
+    string_view username() const { return all_users.username(row); }
+    int total_score() const { return all_users.total_score[row]; }
+    int games_played() const { return all_users.games_played[row]; }
+    const vector<PackedQuestion>& failed_questions() const { return all_users.failed_questions[row]; }
+    const SeenFilter& seen_questions() const { return all_users.seen_questions[row]; }
+    double get_win_rate() const { return all_users.get_win_rate(row); }
+
+    void add_score(int delta) {
+        all_users.total_score[row] += delta;
+        all_users.mark_dirty(row, DIRTY_SCORE);
+        score_store.set_score(row, all_users.total_score[row]);
+        rank_index.set_score(row, all_users.total_score[row]);
+        record_score_event(row, delta);
+        stats_export.publish_player(row);
+        stats_export.publish_top();
+    }
+
+    void record_game(bool won) {
+        all_users.games_played[row]++;
+        if (won) all_users.games_won[row]++;
+        else all_users.games_lost[row]++;
+        all_users.mark_dirty(row, DIRTY_GAMES);
+        stats_export.publish_player(row);
+    }
+
+    void add_failed_question(PackedQuestion q) {
+        all_users.failed_questions[row].push_back(q);
+        all_users.mark_dirty(row, DIRTY_FAILED);
+        stats_export.publish_player(row);
+    }
+
+    void remove_first_failed_question() {
+        auto& questions = all_users.failed_questions[row];
+        questions.erase(questions.begin());
+        all_users.mark_dirty(row, DIRTY_FAILED);
+        stats_export.publish_player(row);
+    }
+
+    void remember_question(PackedQuestion q) {
+        all_users.seen_questions[row].insert(q);
+        all_users.seen_inserts.push_back({static_cast<uint32_t>(row), q});
+        all_users.mark_dirty(row, DIRTY_SEEN);
+    }
+};
+
+UserHandle current_user;
+
+// Password checks and hashing run on a few worker threads so a slow KDF
+// never stalls a frame. The main loop submits jobs and polls for results
+// once per frame; nothing here touches all_users.
+struct LoginWorkers {
+    enum Kind { LOGIN, SIGN_UP };
+
+    struct Job {
+        Kind kind;
+        int row;                // LOGIN: the player's row
+        string username;
+        string password;        // as typed
+        string stored;          // LOGIN: hash or old plaintext from users.txt
+    };
+
+    struct Result {
+        Kind kind;
+        int row;
+        string username;
+        bool ok;
+        string new_hash;        // set when the stored password must be replaced
+    };
+
+    static const size_t MAX_PENDING = 16;
+
+    vector<thread> threads;
+    mutex lock;
+    condition_variable wake;
+    deque<Job> jobs;
+    deque<Result> done;
+    size_t pending = 0;         // submitted but not yet collected by poll()
+    bool stopping = false;
+
+    void start(unsigned count) {
+        stopping = false;
+        for (unsigned i = 0; i < count; ++i) threads.emplace_back(&LoginWorkers::run, this);
+    }
+
+    // Queued jobs are dropped; ones already hashing finish first
+    void stop() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+            jobs.clear();
+        }
+        wake.notify_all();
+        for (auto& worker : threads) worker.join();
+        threads.clear();
+    }
+
+    // Fails when MAX_PENDING jobs are already in flight
+    bool submit(Job job) {
+        {
+            lock_guard<mutex> guard(lock);
+            if (pending >= MAX_PENDING) return false;
+            pending++;
+            jobs.push_back(move(job));
+        }
+        wake.notify_one();
+        return true;
+    }
+
+    bool poll(Result& out) {
+        lock_guard<mutex> guard(lock);
+        if (done.empty()) return false;
+        out = move(done.front());
+        done.pop_front();
+        pending--;
+        return true;
+    }
+
+    void run() {
+        for (;;) {
+            Job job;
+            {
+                unique_lock<mutex> guard(lock);
+                wake.wait(guard, [this] { return stopping || !jobs.empty(); });
+                if (stopping) return;
+                job = move(jobs.front());
+                jobs.pop_front();
+            }
+
+            Result result{job.kind, job.row, job.username, false, ""};
+            if (job.kind == SIGN_UP) {
+                result.new_hash = hash_password(job.password);
+                result.ok = true;
+            } else {
+                result.ok = verify_password(job.password, job.stored);
+                // Records from before hashing are upgraded on their first login
+                if (result.ok && !is_password_hash(job.stored)) result.new_hash = hash_password(job.password);
+            }
+
+            lock_guard<mutex> guard(lock);
+            done.push_back(move(result));
+        }
+    }
+};
+
+const unsigned LOGIN_WORKER_COUNT = 2;
+LoginWorkers login_workers;
 
 // SFML graphics components
 RenderWindow* window;
@@ -58,6 +1034,9 @@ bool graphics_mode = true;
 Clock gameClock;
 Time remainingTime;
 
+vector<LevelDef> levels;
+mt19937 game_rng;
+
 // All the different screens our game can show
 enum GameState {
     AUTH_MENU,
@@ -72,6 +1051,7 @@ enum GameState {
 
 GameState currentState = AUTH_MENU;
 int currentLevel = 0;
+int levelQuestion = 0;
 Question currentQuestion;
 string userInputText = "";
 string usernameInput = "";
@@ -84,9 +1064,126 @@ bool timeUp = false;
 string levelMessage = "";
 int levelScore = 0;
 bool loginError = false;
+bool usernameTooLong = false;
+bool credentialsHaveSpaces = false;
+bool loginPending = false;
+LeaderboardWindow leaderboardWindow = ALL_TIME;
+size_t leaderboardFirst = 0;     // rank in the top row of the All Time board
+
+// Everything the background asset loader hands back to the main thread
+struct LoadedAssets {
+    string font_path;
+    vector<char> font_data;
+    string background_path;
+    Image background;            // already scaled to 800x600
+    bool background_loaded = false;
+    bool background_from_cache = false;
+    double load_ms = 0;
+};
+
+// The font reads glyphs from this buffer lazily, so it must outlive mainFont
+vector<char> fontData;
+future<LoadedAssets> pendingAssets;
+future<void> pendingGameData;
+
+// Decoded, pre-scaled background pixels: "MCBG", source hash, width,
+// height, then raw RGBA. Lets later launches skip JPEG decoding entirely.
+const char* BACKGROUND_CACHE_FILE = "background.cache";
+const char BACKGROUND_CACHE_MAGIC[4] = {'M', 'C', 'B', 'G'};
+const unsigned SCREEN_WIDTH = 800;
+const unsigned SCREEN_HEIGHT = 600;
+
+bool read_file_bytes(const string& path, vector<char>& out) {
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) return false;
+    out.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    return !out.empty();
+}
+
+// 64-bit FNV-1a, used to key the background cache by source file contents
+uint64_t hash_bytes(const vector<char>& data) {
+    uint64_t h = 14695981039346656037ULL;
+    for (char c : data) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Bilinear resize of an RGBA image
+vector<Uint8> scale_pixels(const Uint8* src, unsigned src_w, unsigned src_h, unsigned dst_w, unsigned dst_h) {
+    vector<Uint8> dst(static_cast<size_t>(dst_w) * dst_h * 4);
+    float x_ratio = static_cast<float>(src_w) / dst_w;
+    float y_ratio = static_cast<float>(src_h) / dst_h;
+
+    for (unsigned y = 0; y < dst_h; ++y) {
+        float fy = max(0.0f, (y + 0.5f) * y_ratio - 0.5f);
+        unsigned y0 = min(static_cast<unsigned>(fy), src_h - 1);
+        unsigned y1 = min(y0 + 1, src_h - 1);
+        float wy = fy - y0;
+
+        for (unsigned x = 0; x < dst_w; ++x) {
+            float fx = max(0.0f, (x + 0.5f) * x_ratio - 0.5f);
+            unsigned x0 = min(static_cast<unsigned>(fx), src_w - 1);
+            unsigned x1 = min(x0 + 1, src_w - 1);
+            float wx = fx - x0;
+
+            const Uint8* p00 = src + (static_cast<size_t>(y0) * src_w + x0) * 4;
+            const Uint8* p01 = src + (static_cast<size_t>(y0) * src_w + x1) * 4;
+            const Uint8* p10 = src + (static_cast<size_t>(y1) * src_w + x0) * 4;
+            const Uint8* p11 = src + (static_cast<size_t>(y1) * src_w + x1) * 4;
+            Uint8* out = &dst[(static_cast<size_t>(y) * dst_w + x) * 4];
+            for (int c = 0; c < 4; ++c) {
+                float top = p00[c] + (p01[c] - p00[c]) * wx;
+                float bottom = p10[c] + (p11[c] - p10[c]) * wx;
+                out[c] = static_cast<Uint8>(top + (bottom - top) * wy + 0.5f);
+            }
+        }
+    }
+    return dst;
+}
+
+bool load_background_cache(uint64_t source_hash, Image& image) {
+    ifstream cache(BACKGROUND_CACHE_FILE, ios::binary);
+    if (!cache.is_open()) return false;
+
+    char magic[4];
+    uint64_t hash;
+    uint32_t width, height;
+    cache.read(magic, sizeof(magic));
+    cache.read(reinterpret_cast<char*>(&hash), sizeof(hash));
+    cache.read(reinterpret_cast<char*>(&width), sizeof(width));
+    cache.read(reinterpret_cast<char*>(&height), sizeof(height));
+    if (!cache || memcmp(magic, BACKGROUND_CACHE_MAGIC, sizeof(magic)) != 0 ||
+        hash != source_hash || width != SCREEN_WIDTH || height != SCREEN_HEIGHT) {
+        return false;
+    }
+
+    vector<Uint8> pixels(static_cast<size_t>(width) * height * 4);
+    cache.read(reinterpret_cast<char*>(pixels.data()), pixels.size());
+    if (!cache) return false;
+    image.create(width, height, pixels.data());
+    return true;
+}
+
+void save_background_cache(uint64_t source_hash, const vector<Uint8>& pixels) {
+    ofstream cache(BACKGROUND_CACHE_FILE, ios::binary);
+    if (!cache.is_open()) return;
+    uint32_t width = SCREEN_WIDTH;
+    uint32_t height = SCREEN_HEIGHT;
+    cache.write(BACKGROUND_CACHE_MAGIC, sizeof(BACKGROUND_CACHE_MAGIC));
+    cache.write(reinterpret_cast<const char*>(&source_hash), sizeof(source_hash));
+    cache.write(reinterpret_cast<const char*>(&width), sizeof(width));
+    cache.write(reinterpret_cast<const char*>(&height), sizeof(height));
+    cache.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+}
+
+// Find and decode fonts and images. Runs on a background thread, so it
+// only touches CPU-side objects; textures are created by apply_assets().
+LoadedAssets load_assets() {
+    auto start = chrono::steady_clock::now();
+    LoadedAssets assets;
 
-// Loading game assets like fonts and images
-bool loadResources() {
     // Look for font files in common locations
     const vector<string> fontPaths = {
         "arial.ttf",
@@ -95,11 +1192,9 @@ bool loadResources() {
         "assets/arial.ttf"
     };
     
-    bool fontLoaded = false;
     for (const auto& path : fontPaths) {
-        if (mainFont.loadFromFile(path)) {
-            cout << "Font loaded successfully from: " << path << endl;
-            fontLoaded = true;
+        if (read_file_bytes(path, assets.font_data)) {
+            assets.font_path = path;
             break;
         }
     }
@@ -115,33 +1210,74 @@ bool loadResources() {
         "math.jpg"
     };
     
-    bool bgLoaded = false;
+    vector<char> source;
     for (const auto& path : bgPaths) {
-        if (backgroundTexture.loadFromFile(path)) {
-            cout << "Background image loaded from: " << path << endl;
-            bgLoaded = true;
-            break;
+        if (!read_file_bytes(path, source)) continue;
+
+        uint64_t source_hash = hash_bytes(source);
+        if (load_background_cache(source_hash, assets.background)) {
+            assets.background_from_cache = true;
+        } else {
+            Image decoded;
+            if (!decoded.loadFromMemory(source.data(), source.size())) continue;
+            Vector2u size = decoded.getSize();
+            vector<Uint8> pixels = scale_pixels(decoded.getPixelsPtr(), size.x, size.y, SCREEN_WIDTH, SCREEN_HEIGHT);
+            assets.background.create(SCREEN_WIDTH, SCREEN_HEIGHT, pixels.data());
+            save_background_cache(source_hash, pixels);
+        }
+        assets.background_path = path;
+        assets.background_loaded = true;
+        break;
+    }
+
+    assets.load_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    return assets;
+}
+
+// Turn loaded assets into the font and background sprite (main thread only)
+bool apply_assets(LoadedAssets assets) {
+    bool fontLoaded = false;
+    if (!assets.font_data.empty()) {
+        fontData = move(assets.font_data);
+        if (mainFont.loadFromMemory(fontData.data(), fontData.size())) {
+            cout << "Font loaded successfully from: " << assets.font_path << endl;
+            fontLoaded = true;
         }
     }
     
-    if (bgLoaded) {
+    if (assets.background_loaded && backgroundTexture.loadFromImage(assets.background)) {
+        cout << "Background image loaded from: " << assets.background_path
+             << (assets.background_from_cache ? " (cached)" : " (decoded)") << endl;
         backgroundSprite.setTexture(backgroundTexture);
         
-        // Make background fit our game window perfectly
-        Vector2u textureSize = backgroundTexture.getSize();
-        float scaleX = 800.0f / textureSize.x;
-        float scaleY = 600.0f / textureSize.y;
-        backgroundSprite.setScale(scaleX, scaleY);
-        
         // Make background slightly see-through
         backgroundSprite.setColor(Color(255, 255, 255, 180));
     } else {
         cout << "No background image found - using solid color instead\n";
     }
     
+    cout << "Assets loaded in " << assets.load_ms << " ms" << endl;
     return fontLoaded;
 }
 
+// Placeholder shown while the asset loader is still working
+void drawLoadingScreen(float seconds) {
+    RectangleShape solidBg(Vector2f(800, 600));
+    solidBg.setFillColor(Color(20, 25, 45, 240));
+    window->draw(solidBg);
+
+    RectangleShape track(Vector2f(300, 10));
+    track.setPosition(250, 295);
+    track.setFillColor(Color(50, 50, 50));
+    window->draw(track);
+
+    float phase = seconds - floor(seconds);
+    RectangleShape pulse(Vector2f(60, 10));
+    pulse.setPosition(250 + 240 * phase, 295);
+    pulse.setFillColor(Color::Cyan);
+    window->draw(pulse);
+}
+
 // Draw text on screen with various styling options
 void drawText(const string& text, float x, float y, int size, Color color = Color::White, bool center = false) {
     if (!graphics_mode) return;
@@ -216,8 +1352,14 @@ void drawAuthMenu() {
     drawInputBox(200, 330, 400, 40, string(passwordInput.size(), '*'), passwordActive);
     
     // Show error if login fails
-    if (loginError) {
+    if (loginPending) {
+        drawText("Checking password...", 400, 380, 20, Color::Yellow, true);
+    } else if (loginError) {
         drawText("Login failed! Please sign up first.", 400, 380, 20, Color::Red, true);
+    } else if (usernameTooLong) {
+        drawText("Usernames can be at most " + to_string(MAX_USERNAME_LENGTH) + " characters.", 400, 380, 20, Color::Red, true);
+    } else if (credentialsHaveSpaces) {
+        drawText("Usernames and passwords cannot contain spaces.", 400, 380, 20, Color::Red, true);
     }
     
     drawButton("Login", 250, 400, 150, 50, Color::Green);
@@ -238,7 +1380,7 @@ void drawMainMenu() {
     }
 
     drawText("MAIN MENU", 400, 80, 48, Color::Yellow, true);
-    drawText("Welcome, " + current_user.username + "!", 400, 150, 24, Color::Green, true);
+    drawText("Welcome, " + string(current_user.username()) + "!", 400, 150, 24, Color::Green, true);
     
     drawButton("Play Levels", 300, 200, 200, 50, Color::Green);
     drawButton("Retry Failed", 300, 270, 200, 50, Color::Blue);
@@ -257,10 +1399,14 @@ void drawGameLevel() {
         window->draw(solidBg);
     }
 
-    vector<int> levelTimes = {20, 15, 10};
-    int timeLimit = levelTimes[currentLevel];
-    
-    drawText("Level " + to_string(currentLevel + 1), 400, 50, 36, Color::Yellow, true);
+    const LevelDef& level = levels[currentLevel];
+    int timeLimit = level.time_limit;
+
+    string title = "Level " + to_string(currentLevel + 1);
+    if (level.questions > 1) {
+        title += " - Question " + to_string(levelQuestion + 1) + "/" + to_string(level.questions);
+    }
+    drawText(title, 400, 50, 36, Color::Yellow, true);
     drawText("Time per question: " + to_string(timeLimit) + " seconds", 400, 100, 24, Color::White, true);
     
     drawText("Question: " + currentQuestion.expression, 400, 200, 32, Color::Green, true);
@@ -288,8 +1434,8 @@ void drawGameLevel() {
     
     drawButton("Submit", 350, 430, 100, 40, Color::Green);
     
-    if (remaining <= 0 && !timeUp) {
-        timeUp = true;
+    // Only shown here; the main loop's timeout step sets timeUp
+    if (remaining <= 0) {
         drawText("TIME'S UP!", 400, 500, 36, Color::Red, true);
     }
 }
@@ -306,16 +1452,50 @@ void drawDashboard() {
 
     drawText("PLAYER DASHBOARD", 400, 50, 36, Color::Yellow, true);
     
-    drawText("Username: " + current_user.username, 200, 120, 24);
-    drawText("Total Score: " + to_string(current_user.total_score), 200, 160, 24);
-    drawText("Games Played: " + to_string(current_user.games_played), 200, 200, 24);
+    drawText("Username: " + string(current_user.username()), 200, 120, 24);
+    drawText("Total Score: " + to_string(current_user.total_score()), 200, 160, 24);
+    drawText("Games Played: " + to_string(current_user.games_played()), 200, 200, 24);
     drawText("Win Rate: " + to_string(static_cast<int>(current_user.get_win_rate())) + "%", 200, 240, 24);
-    drawText("Failed Questions: " + to_string(current_user.failed_questions.size()), 200, 280, 24);
+    drawText("Failed Questions: " + to_string(current_user.failed_questions().size()), 200, 280, 24);
     
     drawButton("Back to Menu", 300, 350, 200, 50, Color::Blue);
 }
 
-// Display top players by score
+// Layout of the leaderboard rows and the All Time scrollbar
+const int LEADERBOARD_ROWS = 10;
+const float LEADERBOARD_TOP = 145;
+const float LEADERBOARD_ROW_HEIGHT = 30;
+const float SCROLLBAR_X = 690;
+const float SCROLLBAR_WIDTH = 14;
+
+// Keep the All Time board inside the list with `first` as the top row
+void scroll_leaderboard_to(int64_t first) {
+    int64_t last = max<int64_t>(0, static_cast<int64_t>(rank_index.size()) - LEADERBOARD_ROWS);
+    leaderboardFirst = static_cast<size_t>(clamp<int64_t>(first, 0, last));
+}
+
+// One ranked player; slot is the row on screen
+void drawLeaderboardRow(size_t rank, const ScoreEntry& entry, int slot) {
+    float y = LEADERBOARD_TOP + slot * LEADERBOARD_ROW_HEIGHT;
+    bool isCurrentUser = static_cast<int>(entry.row) == current_user.row;
+    if (isCurrentUser) {
+        RectangleShape highlight(Vector2f(560, LEADERBOARD_ROW_HEIGHT - 2));
+        highlight.setPosition(115, y - 1);
+        highlight.setFillColor(Color(139, 69, 19, 180));
+        window->draw(highlight);
+    }
+
+    string text = to_string(rank + 1) + ". " + string(all_users.username(entry.row)) + " - " + to_string(entry.score) + " pts";
+    Color color = Color::White;
+    if (isCurrentUser) color = Color::Cyan;
+    else if (rank == 0) color = Color::Yellow;
+    else if (rank == 1) color = Color::Red;
+    else if (rank == 2) color = Color(205, 127, 50);
+    drawText(text, 400, y, 22, color, true);
+}
+
+// Display players by score. All Time scrolls through every player, but
+// only the rows in view are fetched from rank_index each frame.
 void drawLeaderboard() {
     if (backgroundTexture.getSize().x > 0) {
         window->draw(backgroundSprite);
@@ -325,28 +1505,63 @@ void drawLeaderboard() {
         window->draw(solidBg);
     }
 
-    drawText("LEADERBOARD", 400, 50, 36, Color::Yellow, true);
-    
-    vector<pair<int, string>> leaders;
-    for (auto& u : all_users) {
-        leaders.push_back({u.total_score, u.username});
+    drawText("LEADERBOARD", 400, 40, 36, Color::Yellow, true);
+
+    const char* tabNames[] = {"All Time", "Last 7 Days", "Last 24h"};
+    for (int tab = 0; tab < 3; tab++) {
+        Color tabColor = tab == leaderboardWindow ? Color(139, 69, 19) : Color(60, 60, 60);
+        drawButton(tabNames[tab], 130 + tab * 185, 95, 170, 35, tabColor);
     }
-    sort(leaders.rbegin(), leaders.rend());
     
-    int y = 120;
-    for (int i = 0; i < min(5, (int)leaders.size()); i++) {
-        string entry = to_string(i + 1) + ". " + leaders[i].second + " - " + to_string(leaders[i].first) + " pts";
-        Color color = Color::White;
-        if (i == 0) color = Color::Yellow;
-        else if (i == 1) color = Color::Red;
-        else if (i == 2) color = Color(205, 127, 50);
-        drawText(entry, 400, y, 24, color, true);
-        y += 40;
+    if (leaderboardWindow != ALL_TIME) {
+        const vector<ScoreEntry>& leaders = windowed_scores.top(leaderboardWindow, LEADERBOARD_SIZE, time(nullptr));
+        if (leaders.empty()) {
+            drawText("No points scored in this period yet", 400, 200, 22, Color::White, true);
+        }
+        for (int i = 0; i < (int)leaders.size(); i++) {
+            drawLeaderboardRow(i, leaders[i], i);
+        }
+    } else {
+        scroll_leaderboard_to(leaderboardFirst);
+        vector<ScoreEntry> rows = rank_index.page(leaderboardFirst, LEADERBOARD_ROWS);
+        for (int i = 0; i < (int)rows.size(); i++) {
+            drawLeaderboardRow(leaderboardFirst + i, rows[i], i);
+        }
+
+        // Scrollbar thumb sized and placed by the share of players in view
+        size_t players = rank_index.size();
+        if (players > LEADERBOARD_ROWS) {
+            float track = LEADERBOARD_ROWS * LEADERBOARD_ROW_HEIGHT;
+            RectangleShape bar(Vector2f(SCROLLBAR_WIDTH, track));
+            bar.setPosition(SCROLLBAR_X, LEADERBOARD_TOP);
+            bar.setFillColor(Color(60, 60, 60));
+            window->draw(bar);
+
+            float thumb = max(20.0f, track * LEADERBOARD_ROWS / players);
+            float along = static_cast<float>(leaderboardFirst) / (players - LEADERBOARD_ROWS);
+            RectangleShape handle(Vector2f(SCROLLBAR_WIDTH, thumb));
+            handle.setPosition(SCROLLBAR_X, LEADERBOARD_TOP + (track - thumb) * along);
+            handle.setFillColor(Color(205, 127, 50));
+            window->draw(handle);
+        }
+
+        string status = "No players yet";
+        if (!rows.empty()) {
+            status = "Ranks " + to_string(leaderboardFirst + 1) + "-" + to_string(leaderboardFirst + rows.size()) +
+                     " of " + to_string(players);
+        }
+        if (current_user.valid()) {
+            status += "  |  You: #" + to_string(rank_index.rank_of(current_user.row) + 1);
+            drawButton("Find Me", 560, 460, 130, 40, Color(60, 60, 60));
+        }
+        drawText(status, 330, 468, 18, Color::White, true);
     }
-    
-    drawButton("Back to Menu", 300, 350, 200, 50, Color(139, 69, 19));
+
+    drawButton("Back to Menu", 300, 520, 200, 50, Color(139, 69, 19));
 }
 
+const Question& retry_front_question();
+
 // Screen for practicing previously missed questions
 void drawRetryFailed() {
     if (backgroundTexture.getSize().x > 0) {
@@ -359,12 +1574,12 @@ void drawRetryFailed() {
 
     drawText("RETRY FAILED QUESTIONS", 400, 50, 36, Color::Yellow, true);
     
-    if (current_user.failed_questions.empty()) {
+    if (current_user.failed_questions().empty()) {
         drawText("No failed questions to retry!", 400, 200, 24, Color::Green, true);
     } else {
-        auto it = current_user.failed_questions.begin();
-        drawText("Question: " + it->expression, 400, 150, 28, Color::White, true);
-        drawText("Correct Answer: " + to_string(it->answer), 400, 200, 24, Color::Cyan, true);
+        const Question& front = retry_front_question();
+        drawText("Question: " + front.expression, 400, 150, 28, Color::White, true);
+        drawText("Correct Answer: " + to_string(front.answer), 400, 200, 24, Color::Cyan, true);
         
         drawInputBox(200, 250, 400, 50, userInputText, true);
         drawButton("Submit Answer", 300, 320, 200, 50, Color::Green);
@@ -407,261 +1622,632 @@ void drawLevelEnd() {
 
 // Set up random number generation for game variety
 void initialize_rng() {
-    srand(static_cast<unsigned>(time(0)));
+    game_rng.seed(static_cast<unsigned>(time(0)));
 }
 
-// Generate random numbers within a range
-int random_num(int min, int max) {
-    if (min > max) swap(min, max);
-    return min + rand() % (max - min + 1);
+// Retry screen's text for the first failed question, rebuilt only when it changes
+const Question& retry_front_question() {
+    static Question cached;
+    static bool has_cached = false;
+    PackedQuestion front = current_user.failed_questions().front();
+    if (!has_cached || cached.packed.bits != front.bits) {
+        cached = materialize_question(front);
+        has_cached = true;
+    }
+    return cached;
+}
+
+const char* USERS_FILE = "users.txt";
+const char* USERS_INDEX_FILE = "users.idx";
+
+// users.idx layout (little-endian, written and read with raw fwrite/fread):
+//   header: "MCIX", version, users.txt size, users.txt write time, row count
+//   rows:   body offset, body length, score, played, won, lost,
+//           failed count, username length, password length,
+//           seen filter lines, name, password
+// The stamp lets us spot a users.txt that was edited behind the index's back.
+const char USERS_INDEX_MAGIC[4] = {'M', 'C', 'I', 'X'};
+const uint32_t USERS_INDEX_VERSION = 2;
+
+struct UsersIndexHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t text_size;
+    int64_t text_mtime;
+    uint64_t row_count;
+};
+
+struct UsersIndexRow {
+    uint64_t body_offset;
+    uint32_t body_length;
+    int32_t total_score;
+    int32_t games_played;
+    int32_t games_won;
+    int32_t games_lost;
+    uint32_t failed_count;
+    uint16_t username_length;
+    uint16_t password_length;
+    uint32_t seen_lines;
+};
+
+// Size and modification time of a users file, used to validate users.idx
+bool users_file_stamp(const char* path, uint64_t& size, int64_t& mtime) {
+    error_code ec;
+    size = filesystem::file_size(path, ec);
+    if (ec) return false;
+    auto when = filesystem::last_write_time(path, ec);
+    if (ec) return false;
+    mtime = static_cast<int64_t>(when.time_since_epoch().count());
+    return true;
+}
+
+// "count word word ..." for a seen filter: the "%" line in users.txt, and
+// the "q" journal record before it held single questions
+string seen_filter_fields(const SeenFilter& filter) {
+    stringstream ss;
+    ss << filter.current_count << hex;
+    for (uint64_t word : filter.words) ss << " " << word;
+    return ss.str();
 }
 
-// Pick a random math operator
-char random_operator() {
-    const char ops[] = {'+', '-', '*', '/'};
-    return ops[rand() % 4];
+bool read_seen_filter_fields(istream& in, SeenFilter& out) {
+    SeenFilter filter;
+    if (!(in >> filter.current_count) || filter.current_count > SeenFilter::GENERATION_SIZE) return false;
+    filter.words.resize(2 * SeenFilter::WORDS);
+    for (auto& word : filter.words) in >> hex >> word;
+    if (!in) return false;
+    out = move(filter);
+    return true;
 }
 
-// Math expression evaluation helpers
-int precedence(char op) {
-    if (op == '+' || op == '-') return 1;
-    if (op == '*' || op == '/') return 2;
-    return 0;
+// Parse one line of a player's body: a failed question ("@hex" or the
+// older "expression~answer") or the seen filter ("%count words...")
+void parse_player_body_line(const string& line, vector<PackedQuestion>& out, SeenFilter& seen) {
+    PackedQuestion q;
+    if (!line.empty() && line[0] == '%') {
+        stringstream ss(line.substr(1));
+        read_seen_filter_fields(ss, seen);
+    } else if (!line.empty() && line[0] == '@') {
+        // Packed form: "@" followed by the hex bits
+        try {
+            q.bits = stoull(line.substr(1), nullptr, 16);
+            out.push_back(q);
+        } catch (...) {
+        }
+    } else {
+        // Older files store "expression~answer"; the answer is recomputed
+        size_t tilde = line.find('~');
+        if (tilde != string::npos && pack_expression(line.substr(0, tilde), q)) {
+            out.push_back(q);
+        }
+    }
+}
+
+// Write the header of every player in table to index_path, stamped with
+// the text file it describes. Only called when users.txt itself is
+// rewritten (compaction, or after parsing it at startup): every body
+// offset moves then, while saves in between go to users.journal and
+// leave both files alone.
+bool save_users_index(const UserTable& table, const char* text_path, const char* index_path) {
+    UsersIndexHeader header;
+    memcpy(header.magic, USERS_INDEX_MAGIC, sizeof(header.magic));
+    header.version = USERS_INDEX_VERSION;
+    header.row_count = table.size();
+    if (!users_file_stamp(text_path, header.text_size, header.text_mtime)) return false;
+
+    FILE* index = fopen(index_path, "wb");
+    if (!index) {
+        cerr << "Could not open " << index_path << " for saving!\n";
+        return false;
+    }
+    fwrite(&header, sizeof(header), 1, index);
+    for (size_t i = 0; i < table.size(); ++i) {
+        string_view name = table.username(i);
+        string_view pass = table.password(i);
+        UsersIndexRow row;
+        row.body_offset = table.body_offset[i];
+        row.body_length = table.body_length[i];
+        row.total_score = table.total_score[i];
+        row.games_played = table.games_played[i];
+        row.games_won = table.games_won[i];
+        row.games_lost = table.games_lost[i];
+        row.failed_count = static_cast<uint32_t>(table.failed_count(i));
+        row.username_length = static_cast<uint16_t>(name.size());
+        row.password_length = static_cast<uint16_t>(pass.size());
+        row.seen_lines = table.stored_seen_lines[i];
+        fwrite(&row, sizeof(row), 1, index);
+        fwrite(name.data(), 1, name.size(), index);
+        fwrite(pass.data(), 1, pass.size(), index);
+    }
+    return fclose(index) == 0;
+}
+
+// Read player headers from users.idx. Fails if the index is missing,
+// corrupt or older than users.txt, in which case the text file is parsed.
+bool load_users_index() {
+    uint64_t text_size;
+    int64_t text_mtime;
+    if (!users_file_stamp(USERS_FILE, text_size, text_mtime)) return false;
+
+    ifstream index(USERS_INDEX_FILE, ios::binary);
+    if (!index.is_open()) return false;
+    vector<char> data((istreambuf_iterator<char>(index)), istreambuf_iterator<char>());
+
+    UsersIndexHeader header;
+    if (data.size() < sizeof(header)) return false;
+    memcpy(&header, data.data(), sizeof(header));
+    if (memcmp(header.magic, USERS_INDEX_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != USERS_INDEX_VERSION ||
+        header.text_size != text_size || header.text_mtime != text_mtime) {
+        return false;
+    }
+
+    UserTable table;
+    size_t pos = sizeof(header);
+    for (uint64_t r = 0; r < header.row_count; ++r) {
+        UsersIndexRow row;
+        if (pos + sizeof(row) > data.size()) return false;
+        memcpy(&row, data.data() + pos, sizeof(row));
+        pos += sizeof(row);
+        if (pos + row.username_length + row.password_length > data.size()) return false;
+
+        User u;
+        u.username.assign(data.data() + pos, row.username_length);
+        pos += row.username_length;
+        u.password.assign(data.data() + pos, row.password_length);
+        pos += row.password_length;
+        u.total_score = row.total_score;
+        u.games_played = row.games_played;
+        u.games_won = row.games_won;
+        u.games_lost = row.games_lost;
+
+        size_t i = table.add(move(u));
+        table.body_offset[i] = row.body_offset;
+        table.body_length[i] = row.body_length;
+        table.stored_failed_count[i] = row.failed_count;
+        table.stored_seen_lines[i] = row.seen_lines;
+        table.questions_loaded[i] = 0;
+    }
+
+    all_users = move(table);
+    return true;
 }
 
-// Perform actual math operations
-double applyOp(double a, double b, char op) {
-    switch (op) {
-        case '+': return a + b;
-        case '-': return a - b;
-        case '*': return a * b;
-        case '/': 
-            return (abs(b) < 1e-9) ? 1e99 : a / b;
+// Read one player's failed questions and seen filter from users.txt on demand
+void page_in_player_body(size_t row) {
+    if (all_users.questions_loaded[row]) return;
+
+    vector<PackedQuestion> questions;
+    SeenFilter seen;
+    questions.reserve(all_users.stored_failed_count[row]);
+    ifstream file(USERS_FILE, ios::binary);
+    if (file.is_open() && all_users.body_length[row] > 0) {
+        string body(all_users.body_length[row], '\0');
+        file.seekg(static_cast<streamoff>(all_users.body_offset[row]));
+        file.read(&body[0], body.size());
+
+        stringstream lines(body);
+        string line;
+        while (getline(lines, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            parse_player_body_line(line, questions, seen);
+        }
     }
-    return 0;
+    all_users.failed_questions[row] = move(questions);
+    all_users.seen_questions[row] = move(seen);
+    all_users.questions_loaded[row] = 1;
 }
 
-// Calculate answer for math expressions
-double evaluate_expression(const string& expr) {
-    stack<double> values;
-    stack<char> ops;
-
-    for (int i = 0; i < expr.size(); ++i) {
-        if (expr[i] == ' ') continue;
+const char* USERS_JOURNAL_FILE = "users.journal";
+const long USERS_JOURNAL_LIMIT = 256 * 1024;
+FILE* users_journal = nullptr;
+
+// While a background compaction runs, the journal it is folding into
+// users.txt sits here and new changes go to a fresh users.journal
+const char* USERS_OLD_JOURNAL_FILE = "users.journal.old";
+const char* USERS_TEMP_FILE = "users.txt.tmp";
+const char* USERS_INDEX_TEMP_FILE = "users.idx.tmp";
+
+// Write every player in table to text_path and its index to index_path,
+// moving the table's body offsets to the new file
+bool write_users_files(UserTable& table, const char* text_path, const char* index_path) {
+    // Players that were never paged in keep their failed-question and
+    // seen-filter lines, copied byte for byte without parsing them
+    ifstream old_file(USERS_FILE, ios::binary);
+    ofstream file(text_path, ios::binary);
+    if (!file.is_open()) {
+        cerr << "Could not open " << text_path << " for saving!\n";
+        return false;
+    }
 
-        if (isdigit(expr[i])) {
-            double val = 0;
-            while (i < expr.size() && isdigit(expr[i])) {
-                val = val * 10 + (expr[i] - '0');
-                i++;
+    cout << "Saving " << table.size() << " players to file...\n";
+    
+    string body;
+    uint64_t offset = 0;
+    for (size_t i = 0; i < table.size(); ++i) {
+        if (table.questions_loaded[i]) {
+            body.clear();
+            for (auto& q : table.failed_questions[i]) {
+                stringstream hex_line;
+                hex_line << "@" << hex << q.bits << "\n";
+                body += hex_line.str();
             }
-            i--;
-            values.push(val);
+            const SeenFilter& seen = table.seen_questions[i];
+            table.stored_seen_lines[i] = seen.empty() ? 0 : 1;
+            if (!seen.empty()) body += "%" + seen_filter_fields(seen) + "\n";
         } else {
-            char op = expr[i];
-            while (!ops.empty() && precedence(ops.top()) >= precedence(op)) {
-                double val2 = values.top(); values.pop();
-                double val1 = values.top(); values.pop();
-                char top_op = ops.top(); ops.pop();
-                values.push(applyOp(val1, val2, top_op));
-            }
-            ops.push(op);
+            body.assign(table.body_length[i], '\0');
+            old_file.seekg(static_cast<streamoff>(table.body_offset[i]));
+            old_file.read(&body[0], body.size());
         }
-    }
 
-    while (!ops.empty()) {
-        double val2 = values.top(); values.pop();
-        double val1 = values.top(); values.pop();
-        char op = ops.top(); ops.pop();
-        values.push(applyOp(val1, val2, op));
+        stringstream header;
+        header << table.username(i) << " " << table.password(i) << " " << table.total_score[i] << " "
+               << table.games_played[i] << " " << table.games_won[i] << " " << table.games_lost[i] << " "
+               << table.failed_count(i);
+        if (table.stored_seen_lines[i] > 0) header << " " << table.stored_seen_lines[i];
+        header << "\n";
+        string header_line = header.str();
+        file << header_line << body;
+
+        offset += header_line.size();
+        table.body_offset[i] = offset;
+        table.body_length[i] = static_cast<uint32_t>(body.size());
+        offset += body.size();
     }
 
-    return values.top();
+    old_file.close();
+    file.close();
+    if (!file) return false;
+    return save_users_index(table, text_path, index_path);
 }
 
-// Handle fractions in user answers
-double evaluate_fractional_input(const string& input) {
-    size_t slash = input.find('/');
-    if (slash != string::npos) {
-        try {
-            double num = stod(input.substr(0, slash));
-            double den = stod(input.substr(slash + 1));
-            if (abs(den) < 1e-9) return numeric_limits<double>::infinity();
-            return num / den;
-        } catch (...) {
-            return numeric_limits<double>::quiet_NaN();
+bool replace_file(const char* from, const char* to) {
+    if (rename(from, to) == 0) return true;
+    // Windows will not rename over an existing file
+    remove(to);
+    if (rename(from, to) == 0) return true;
+    cerr << "Could not replace " << to << "!\n";
+    return false;
+}
+
+// A compaction running on a worker thread from a copy of the table, so
+// the render thread only pays for the copy
+struct UsersCompaction {
+    thread worker;
+    atomic<bool> done{false};
+    bool ok = false;
+    UserTable snapshot;
+
+    bool running() const { return worker.joinable(); }
+};
+
+UsersCompaction users_compaction;
+
+// Install a finished background compaction. With wait, block until the
+// worker ends; otherwise return at once if it is still writing.
+void finish_users_compaction(bool wait) {
+    if (!users_compaction.running()) return;
+    if (!wait && !users_compaction.done.load()) return;
+    users_compaction.worker.join();
+
+    UserTable& snapshot = users_compaction.snapshot;
+    if (users_compaction.ok && replace_file(USERS_TEMP_FILE, USERS_FILE)) {
+        replace_file(USERS_INDEX_TEMP_FILE, USERS_INDEX_FILE);
+        remove(USERS_OLD_JOURNAL_FILE);
+        // Players not paged in read their bodies from the new file now
+        for (size_t i = 0; i < snapshot.size(); ++i) {
+            all_users.body_offset[i] = snapshot.body_offset[i];
+            all_users.body_length[i] = snapshot.body_length[i];
+            all_users.stored_seen_lines[i] = snapshot.stored_seen_lines[i];
         }
+        cout << "Compacted " << snapshot.size() << " players into " << USERS_FILE << endl;
     }
-    return stod(input);
+    snapshot = UserTable();
 }
 
-// Check if user's answer matches the correct one
-bool is_answer_correct(const string& user_input, double correct_answer) {
-    double user_ans;
-    try {
-        user_ans = evaluate_fractional_input(user_input);
-    } catch (...) {
-        return false;
+// Rewrite users.txt and users.idx from the table and start a fresh
+// journal. Used at exit; blocks until any background compaction is done.
+void compact_users_file() {
+    finish_users_compaction(true);
+    if (!write_users_files(all_users, USERS_TEMP_FILE, USERS_INDEX_TEMP_FILE) ||
+        !replace_file(USERS_TEMP_FILE, USERS_FILE)) {
+        return;
     }
+    replace_file(USERS_INDEX_TEMP_FILE, USERS_INDEX_FILE);
 
-    const double TOLERANCE_EXACT = 0.01;
-    const double TOLERANCE_DECIMAL = 0.1;
-
-    if (fabs(user_ans - correct_answer) < TOLERANCE_DECIMAL) return true;
+    if (users_journal) {
+        fclose(users_journal);
+        users_journal = nullptr;
+    }
+    remove(USERS_JOURNAL_FILE);
+    remove(USERS_OLD_JOURNAL_FILE);
+    all_users.clear_dirty();
+    
+    cout << "All player data saved successfully!\n";
+}
 
-    if (fabs(correct_answer - floor(correct_answer)) < TOLERANCE_EXACT &&
-        fabs(user_ans - floor(correct_answer)) < TOLERANCE_EXACT) return true;
+// Fold the journal into users.txt on a worker thread. Changes made while
+// it runs land in a fresh journal, so a crash at any point loses nothing.
+void start_users_compaction() {
+    if (users_compaction.running()) return;
+    if (users_journal) {
+        fclose(users_journal);
+        users_journal = nullptr;
+    }
+    // A journal left over from a failed compaction must not be replaced
+    if (filesystem::exists(USERS_OLD_JOURNAL_FILE) || !replace_file(USERS_JOURNAL_FILE, USERS_OLD_JOURNAL_FILE)) {
+        compact_users_file();
+        return;
+    }
 
-    return false;
+    users_compaction.snapshot = all_users.copy_for_saving();
+    users_compaction.done = false;
+    users_compaction.worker = thread([] {
+        users_compaction.ok = write_users_files(users_compaction.snapshot, USERS_TEMP_FILE, USERS_INDEX_TEMP_FILE);
+        users_compaction.done = true;
+    });
 }
 
-// Create random math questions based on level difficulty
-Question generate_random_question(int level) {
-    Question q;
-    stringstream ss;
-    int num_ops;
-    int min_val, max_val;
-    
-    if (level == 1) {
-        num_ops = 1;
-        min_val = 1;
-        max_val = 10;
-    } else {
-        num_ops = random_num(2, 3); 
-        min_val = 5 * level;
-        max_val = 15 * level;
+// Append only the changed fields of dirty players to users.journal.
+// Records hold absolute values, so replaying one twice is harmless; the
+// exception is q, which at worst rotates the seen filter a little early.
+//   n <name> <password>          new player
+//   s <name> <score>
+//   g <name> <played> <won> <lost>
+//   f <name> <count> <hex>...    whole failed question list
+//   q <name> <hex>               one question added to the seen filter
+//   p <name> <password hash>
+void save_users() {
+    if (all_users.dirty_rows.empty()) return;
+
+    if (!users_journal) users_journal = open_log_for_append(USERS_JOURNAL_FILE);
+    if (!users_journal) {
+        cerr << "Could not open " << USERS_JOURNAL_FILE << " for saving!\n";
+        return;
     }
 
-    char last_op = ' ';
-    bool division_used = false;
+    for (uint32_t row : all_users.dirty_rows) {
+        uint8_t fields = all_users.dirty[row];
+        string_view name = all_users.username(row);
+        int name_length = static_cast<int>(name.size());
 
-    ss << random_num(min_val, max_val);
-    
-    for (int i = 0; i < num_ops; ++i) {
-        char op;
-        int next;
-        
-        do {
-            op = random_operator();
-            if (level == 3 && op == '/' && division_used) {
-                op = random_operator();
-            }
-
-            if (last_op == '/' && op == '*') continue; 
-            if (last_op == '*' && op == '/') continue;
-
-            next = random_num(min_val, max_val);
-
-            if (op == '/') {
-                while (next == 0) next = random_num(min_val, max_val);
-                int current_val = evaluate_expression(ss.str());
-                if (current_val % next != 0 && (current_val * 4) % next != 0) {
-                    vector<int> clean_divisors = {2, 4, 5, 8, 10};
-                    next = current_val;
-                    while (next == current_val || (current_val % next != 0 && (current_val * 2) % next != 0 && (current_val * 4) % next != 0)) {
-                        if (current_val % 10 == 0 && i < num_ops - 1) {
-                            next = clean_divisors[rand() % clean_divisors.size()];
-                        } else {
-                            next = random_num(1, 10);
-                        }
-                    }
-                }
+        if (fields & DIRTY_NEW) {
+            string_view pass = all_users.password(row);
+            fprintf(users_journal, "n %.*s %.*s\n", name_length, name.data(),
+                    static_cast<int>(pass.size()), pass.data());
+        }
+        if (fields & DIRTY_SCORE) {
+            fprintf(users_journal, "s %.*s %d\n", name_length, name.data(), all_users.total_score[row]);
+        }
+        if (fields & DIRTY_GAMES) {
+            fprintf(users_journal, "g %.*s %d %d %d\n", name_length, name.data(), all_users.games_played[row],
+                    all_users.games_won[row], all_users.games_lost[row]);
+        }
+        if (fields & DIRTY_FAILED) {
+            const auto& questions = all_users.failed_questions[row];
+            fprintf(users_journal, "f %.*s %u", name_length, name.data(), static_cast<unsigned>(questions.size()));
+            for (const auto& q : questions) {
+                fprintf(users_journal, " %llx", static_cast<unsigned long long>(q.bits));
             }
-        } while (last_op == op);
-
-        if (level == 3 && op == '/') division_used = true;
-        
-        ss << " " << op << " " << next;
-        last_op = op;
+            fputc('\n', users_journal);
+        }
+        if (fields & DIRTY_PASSWORD) {
+            string_view pass = all_users.password(row);
+            fprintf(users_journal, "p %.*s %.*s\n", name_length, name.data(),
+                    static_cast<int>(pass.size()), pass.data());
+        }
+    }
+    for (const auto& insert : all_users.seen_inserts) {
+        string_view name = all_users.username(insert.first);
+        fprintf(users_journal, "q %.*s %llx\n", static_cast<int>(name.size()), name.data(),
+                static_cast<unsigned long long>(insert.second.bits));
     }
+    fflush(users_journal);
 
-    q.expression = ss.str();
-    q.answer = evaluate_expression(q.expression);
-    return q;
+    cout << "Saved changes for " << all_users.dirty_rows.size() << " player(s)\n";
+    all_users.clear_dirty();
+
+    if (ftell(users_journal) > USERS_JOURNAL_LIMIT) {
+        start_users_compaction();
+    }
 }
 
-// Update current player's data in the users list
-void update_user_record() {
-    for (size_t i = 0; i < all_users.size(); ++i) {
-        if (all_users[i].username == current_user.username) {
-            all_users[i] = current_user;
-            cout << "Updated player record: " << current_user.username 
-                 << " Score: " << current_user.total_score 
-                 << " Win Rate: " << current_user.get_win_rate() << "%" << endl;
-            return;
+// Apply changes saved since users.txt was last rewritten
+void replay_users_journal(const char* path) {
+    ifstream journal(path, ios::binary);
+    if (!journal.is_open()) return;
+
+    string line;
+    size_t applied = 0;
+    while (getline(journal, line)) {
+        // A line cut short by a crash has no newline; ignore it
+        if (journal.eof()) break;
+
+        stringstream ss(line);
+        char kind;
+        string name;
+        if (!(ss >> kind >> name)) continue;
+
+        int row = all_users.find(name);
+        if (kind == 'n') {
+            string pass;
+            if (row < 0 && ss >> pass) {
+                all_users.add(name, pass);
+                applied++;
+            }
+            continue;
+        }
+        if (row < 0) continue;
+
+        if (kind == 's') {
+            ss >> all_users.total_score[row];
+        } else if (kind == 'g') {
+            ss >> all_users.games_played[row] >> all_users.games_won[row] >> all_users.games_lost[row];
+        } else if (kind == 'f') {
+            unsigned count = 0;
+            ss >> count;
+            vector<PackedQuestion> questions(count);
+            for (auto& q : questions) ss >> hex >> q.bits;
+            if (!ss) continue;
+            // Page in first so the row's seen filter is not lost
+            page_in_player_body(row);
+            all_users.failed_questions[row] = move(questions);
+        } else if (kind == 'p') {
+            string pass;
+            if (!(ss >> pass)) continue;
+            all_users.passwords[row] = all_users.intern(pass);
+        } else if (kind == 'q') {
+            // One question, or the whole filter in older journals
+            string rest;
+            getline(ss >> ws, rest);
+            stringstream fields(rest);
+            PackedQuestion q;
+            SeenFilter seen;
+            if (rest.find(' ') == string::npos) {
+                if (!(fields >> hex >> q.bits)) continue;
+                page_in_player_body(row);
+                all_users.seen_questions[row].insert(q);
+            } else {
+                if (!read_seen_filter_fields(fields, seen)) continue;
+                page_in_player_body(row);
+                all_users.seen_questions[row] = move(seen);
+            }
         }
+        applied++;
+    }
+
+    if (applied > 0) {
+        cout << "Replayed " << applied << " saved changes from " << path << endl;
     }
-    all_users.push_back(current_user);
-    cout << "Added new player: " << current_user.username << endl;
 }
 
-// Save all player data to file
-void save_users() {
-    update_user_record();
+void load_users_text();
 
-    ofstream file("users.txt");
-    if (!file.is_open()) {
-        cerr << "Could not open users.txt for saving!\n";
-        return;
+// Rebuild the daily/weekly buckets from score_events.log, dropping events
+// older than a week from the file
+void load_score_events() {
+    windowed_scores = WindowedLeaderboard();
+    ifstream log(SCORE_EVENTS_FILE, ios::binary);
+    if (!log.is_open()) return;
+
+    int64_t now = static_cast<int64_t>(time(nullptr));
+    int64_t oldest_day = now / 86400 - 6;
+    string line;
+    vector<string> kept;
+    size_t total = 0;
+    while (getline(log, line)) {
+        total++;
+        if (log.eof()) break;   // cut short by a crash; the rewrite below drops it
+        stringstream ss(line);
+        long long when;
+        string name;
+        int delta;
+        if (!(ss >> when >> name >> delta) || when / 86400 < oldest_day) continue;
+        int row = all_users.find(name);
+        if (row < 0) continue;
+        windowed_scores.record(row, delta, when);
+        kept.push_back(line);
     }
+    log.close();
 
-    cout << "Saving " << all_users.size() << " players to file...\n";
-    
-    for (auto& u : all_users) {
-        file << u.username << " " << u.password << " " << u.total_score << " "
-             << u.games_played << " " << u.games_won << " " << u.games_lost << " "
-             << u.failed_questions.size() << "\n";
-        
-        cout << "Saved: " << u.username << " | Score: " << u.total_score 
-             << " | Games: " << u.games_played << " | Win Rate: " << u.get_win_rate() << "%" << endl;
-        
-        for (auto& q : u.failed_questions)
-            file << q.expression << "~" << q.answer << "\n";
+    if (kept.size() < total) {
+        if (score_events) {
+            fclose(score_events);
+            score_events = nullptr;
+        }
+        ofstream rewrite(SCORE_EVENTS_FILE, ios::binary | ios::trunc);
+        for (const auto& event : kept) rewrite << event << "\n";
     }
-    
-    cout << "All player data saved successfully!\n";
 }
 
 // Load player data from file
 void load_users() {
     all_users.clear();
-    ifstream file("users.txt");
+    if (load_users_index()) {
+        cout << "Loaded " << all_users.size() << " players from " << USERS_INDEX_FILE << endl;
+    } else {
+        load_users_text();
+    }
+    // A journal set aside by an unfinished compaction holds older changes
+    replay_users_journal(USERS_OLD_JOURNAL_FILE);
+    replay_users_journal(USERS_JOURNAL_FILE);
+    load_score_events();
+    score_store.rebuild(all_users.total_score);
+    rank_index.rebuild(all_users.total_score);
+    stats_export.publish_all();
+}
+
+// Everything the game needs besides fonts and images; runs on a loader thread
+void load_game_data() {
+    initialize_rng();
+    levels = load_levels();
+    stats_export.open();
+    load_users();
+}
+
+// Parse every player out of users.txt and rebuild users.idx
+void load_users_text() {
+    ifstream file(USERS_FILE, ios::binary);
     if (!file.is_open()) return;
 
     string line;
-    while (getline(file, line)) {
+    uint64_t offset = 0;
+    auto next_line = [&]() {
+        if (!getline(file, line)) return false;
+        offset += line.size() + 1;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        return true;
+    };
+
+    while (next_line()) {
         stringstream ss(line);
         User u;
         int fail_count = 0;
+        int seen_lines = 0;
         
         if (!(ss >> u.username >> u.password >> u.total_score >> u.games_played
                      >> u.games_won >> u.games_lost >> fail_count)) {
             continue;
         }
+        // Optional: the seen filter line that follows the failed questions
+        if (!(ss >> seen_lines)) seen_lines = 0;
 
-        for (int i = 0; i < fail_count; ++i) {
-            if (getline(file, line)) {
-                size_t tilde = line.find('~');
-                if (tilde != string::npos) {
-                    Question q;
-                    q.expression = line.substr(0, tilde);
-                    try {
-                        q.answer = stod(line.substr(tilde + 1));
-                        u.failed_questions.push_back(q);
-                    } catch (...) {
-                        continue;
-                    }
-                }
+        uint64_t body_start = offset;
+        for (int i = 0; i < fail_count + seen_lines; ++i) {
+            if (next_line()) {
+                parse_player_body_line(line, u.failed_questions, u.seen);
             }
         }
-        all_users.push_back(u);
+        size_t row = all_users.add(move(u));
+        all_users.body_offset[row] = body_start;
+        all_users.body_length[row] = static_cast<uint32_t>(offset - body_start);
+    }
+
+    // The last line may not end in a newline
+    uint64_t text_size;
+    int64_t text_mtime;
+    if (users_file_stamp(USERS_FILE, text_size, text_mtime) && all_users.size() > 0) {
+        size_t last = all_users.size() - 1;
+        if (all_users.body_offset[last] + all_users.body_length[last] > text_size) {
+            all_users.body_length[last] = static_cast<uint32_t>(text_size - min(text_size, all_users.body_offset[last]));
+        }
     }
+
+    file.close();
+    save_users_index(all_users, USERS_FILE, USERS_INDEX_FILE);
+}
+
+bool has_whitespace(const string& text) {
+    return any_of(text.begin(), text.end(), [](char c) { return isspace(static_cast<unsigned char>(c)); });
 }
 
 // Handle login/signup screen interactions
 void handleAuthMenuInput(Event& event) {
     if (event.type == Event::MouseButtonPressed && event.mouseButton.button == Mouse::Left) {
         loginError = false;
+        usernameTooLong = false;
+        credentialsHaveSpaces = false;
         
         if (isMouseOver(200, 230, 400, 40)) {
             usernameActive = true;
@@ -671,39 +2257,24 @@ void handleAuthMenuInput(Event& event) {
             usernameActive = false;
             passwordActive = true;
             inputActive = true;
-        } else if (isMouseOver(250, 400, 150, 50)) {
-            // Try to log player in
-            bool loginSuccess = false;
-            for (auto& u : all_users) {
-                if (u.username == usernameInput && u.password == passwordInput) {
-                    current_user = u;
-                    currentState = MAIN_MENU;
-                    usernameInput = "";
-                    passwordInput = "";
-                    loginSuccess = true;
-                    break;
-                }
-            }
-            if (!loginSuccess) {
+        } else if (isMouseOver(250, 400, 150, 50) && !loginPending) {
+            // Try to log player in; the password is checked on a worker
+            int row = all_users.find(usernameInput);
+            if (row >= 0) {
+                loginPending = login_workers.submit({LoginWorkers::LOGIN, row, usernameInput, passwordInput,
+                                                     string(all_users.password(row))});
+            } else {
                 loginError = true;
             }
-        } else if (isMouseOver(450, 400, 150, 50)) {
-            // Create new player account
-            bool userExists = false;
-            for (auto& u : all_users) {
-                if (u.username == usernameInput) {
-                    userExists = true;
-                    break;
-                }
-            }
-            if (!userExists && !usernameInput.empty() && !passwordInput.empty()) {
-                User new_user{usernameInput, passwordInput};
-                all_users.push_back(new_user);
-                current_user = new_user;
-                currentState = MAIN_MENU;
-                usernameInput = "";
-                passwordInput = "";
-                save_users();
+        } else if (isMouseOver(450, 400, 150, 50) && !loginPending) {
+            // Create new player account once its password is hashed
+            bool userExists = all_users.find(usernameInput) >= 0;
+            usernameTooLong = usernameInput.size() > MAX_USERNAME_LENGTH;
+            // users.journal and users.txt split records on spaces
+            credentialsHaveSpaces = has_whitespace(usernameInput) || has_whitespace(passwordInput);
+            if (!userExists && !usernameTooLong && !credentialsHaveSpaces &&
+                !usernameInput.empty() && !passwordInput.empty()) {
+                loginPending = login_workers.submit({LoginWorkers::SIGN_UP, -1, usernameInput, passwordInput, ""});
             }
         } else if (isMouseOver(350, 470, 100, 40)) {
             window->close();
@@ -721,12 +2292,51 @@ void handleAuthMenuInput(Event& event) {
     }
 }
 
+// Finish logins and sign-ups whose password work is done
+void handleLoginResults() {
+    LoginWorkers::Result result;
+    while (login_workers.poll(result)) {
+        loginPending = false;
+        if (!result.ok) {
+            loginError = true;
+            continue;
+        }
+
+        int row = result.row;
+        if (result.kind == LoginWorkers::LOGIN) {
+            if (!result.new_hash.empty()) {
+                all_users.passwords[row] = all_users.intern(result.new_hash);
+                all_users.mark_dirty(row, DIRTY_PASSWORD);
+            }
+            page_in_player_body(row);
+        } else {
+            if (all_users.find(result.username) >= 0) {
+                loginError = true;
+                continue;
+            }
+            row = static_cast<int>(all_users.add(result.username, result.new_hash));
+            all_users.mark_dirty(row, DIRTY_NEW);
+            score_store.set_score(row, 0);
+            rank_index.set_score(row, 0);
+            stats_export.publish_player(row);
+            stats_export.publish_top();
+        }
+
+        current_user.row = row;
+        currentState = MAIN_MENU;
+        usernameInput = "";
+        passwordInput = "";
+        save_users();
+    }
+}
+
 // Handle main menu button clicks
 void handleMainMenuInput(Event& event) {
     if (event.type == Event::MouseButtonPressed && event.mouseButton.button == Mouse::Left) {
         if (isMouseOver(300, 200, 200, 50)) {
             currentState = LEVEL_START;
             currentLevel = 0;
+            levelQuestion = 0;
             gameStarted = true;
             timeUp = false;
             userInputText = "";
@@ -741,7 +2351,43 @@ void handleMainMenuInput(Event& event) {
         } else if (isMouseOver(300, 480, 200, 50)) {
             currentState = AUTH_MENU;
             save_users();
+            current_user.row = -1;
+        }
+    }
+}
+
+// Put a fresh question from the current level on screen
+void start_question() {
+    currentQuestion = generate_fresh_question(levels[currentLevel], game_rng, current_user.seen_questions());
+    current_user.remember_question(currentQuestion.packed);
+    gameClock.restart();
+    timeUp = false;
+    userInputText = "";
+    currentState = PLAYING_LEVEL;
+}
+
+// Move on after a question: next question, next level, or the results
+void finish_question() {
+    userInputText = "";
+    levelQuestion++;
+    if (levelQuestion < levels[currentLevel].questions) {
+        start_question();
+        return;
+    }
+
+    levelQuestion = 0;
+    currentLevel++;
+    if (currentLevel < (int)levels.size()) {
+        currentState = LEVEL_START;
+    } else {
+        // Show final level results
+        if (levelScore > 0) {
+            levelMessage = "LEVEL PASSED! ";
+        } else {
+            levelMessage = "LEVEL FAILED! ";
         }
+        current_user.record_game(levelScore > 0);
+        currentState = LEVEL_END;
     }
 }
 
@@ -760,37 +2406,19 @@ void handleGameLevelInput(Event& event) {
             int scoreChange = 0;
             
             if (userInputText == "s" || userInputText == "S") {
-                current_user.failed_questions.push_back(currentQuestion);
+                current_user.add_failed_question(currentQuestion.packed);
                 scoreChange = -5;
-            } else if (is_answer_correct(userInputText, currentQuestion.answer)) {
+            } else if (is_answer_correct(userInputText, currentQuestion.packed)) {
                 scoreChange = 10;
             } else {
-                current_user.failed_questions.push_back(currentQuestion);
+                current_user.add_failed_question(currentQuestion.packed);
                 scoreChange = -5;
             }
             
-            current_user.total_score += scoreChange;
+            current_user.add_score(scoreChange);
             levelScore += scoreChange;
-            update_user_record();
             save_users();
-            
-            userInputText = "";
-            currentLevel++;
-            
-            if (currentLevel < 3) {
-                currentState = LEVEL_START;
-            } else {
-                // Show final level results
-                if (levelScore > 0) {
-                    levelMessage = "LEVEL PASSED! ";
-                    current_user.games_won++;
-                } else {
-                    levelMessage = "LEVEL FAILED! ";
-                    current_user.games_lost++;
-                }
-                current_user.games_played++;
-                currentState = LEVEL_END;
-            }
+            finish_question();
         }
     }
 }
@@ -804,12 +2432,45 @@ void handleDashboardInput(Event& event) {
     }
 }
 
-// Handle leaderboard navigation
+// Handle leaderboard navigation. The All Time board scrolls with the
+// mouse wheel, the arrow and page keys, or a click on the scrollbar.
 void handleLeaderboardInput(Event& event) {
+    int64_t first = static_cast<int64_t>(leaderboardFirst);
+    int64_t players = static_cast<int64_t>(rank_index.size());
+
     if (event.type == Event::MouseButtonPressed && event.mouseButton.button == Mouse::Left) {
-        if (isMouseOver(300, 350, 200, 50)) {
+        if (isMouseOver(300, 520, 200, 50)) {
             currentState = MAIN_MENU;
         }
+        for (int tab = 0; tab < 3; tab++) {
+            if (isMouseOver(130 + tab * 185, 95, 170, 35)) {
+                leaderboardWindow = static_cast<LeaderboardWindow>(tab);
+            }
+        }
+        if (leaderboardWindow != ALL_TIME) return;
+
+        if (current_user.valid() && isMouseOver(560, 460, 130, 40)) {
+            scroll_leaderboard_to(static_cast<int64_t>(rank_index.rank_of(current_user.row)) - LEADERBOARD_ROWS / 2);
+        } else if (isMouseOver(SCROLLBAR_X, LEADERBOARD_TOP, SCROLLBAR_WIDTH, LEADERBOARD_ROWS * LEADERBOARD_ROW_HEIGHT)) {
+            double along = (event.mouseButton.y - LEADERBOARD_TOP) / (LEADERBOARD_ROWS * LEADERBOARD_ROW_HEIGHT);
+            scroll_leaderboard_to(static_cast<int64_t>(along * players) - LEADERBOARD_ROWS / 2);
+        }
+    }
+
+    if (leaderboardWindow != ALL_TIME) return;
+    if (event.type == Event::MouseWheelScrolled) {
+        scroll_leaderboard_to(first - static_cast<int64_t>(event.mouseWheelScroll.delta * 3));
+    }
+    if (event.type == Event::KeyPressed) {
+        switch (event.key.code) {
+            case Keyboard::Up: scroll_leaderboard_to(first - 1); break;
+            case Keyboard::Down: scroll_leaderboard_to(first + 1); break;
+            case Keyboard::PageUp: scroll_leaderboard_to(first - LEADERBOARD_ROWS); break;
+            case Keyboard::PageDown: scroll_leaderboard_to(first + LEADERBOARD_ROWS); break;
+            case Keyboard::Home: scroll_leaderboard_to(0); break;
+            case Keyboard::End: scroll_leaderboard_to(players); break;
+            default: break;
+        }
     }
 }
 
@@ -819,26 +2480,24 @@ void handleRetryFailedInput(Event& event) {
         if (isMouseOver(300, 460, 200, 50)) {
             currentState = MAIN_MENU;
             userInputText = "";
-        } else if (!current_user.failed_questions.empty()) {
+        } else if (!current_user.failed_questions().empty()) {
             if (isMouseOver(300, 320, 200, 50)) {
-                auto it = current_user.failed_questions.begin();
-                if (is_answer_correct(userInputText, it->answer)) {
-                    current_user.total_score += 10;
-                    current_user.failed_questions.erase(it);
-                    update_user_record();
-                    save_users(); 
+                if (is_answer_correct(userInputText, current_user.failed_questions().front())) {
+                    current_user.add_score(10);
+                    current_user.remove_first_failed_question();
+                    save_users();
                 }
                 userInputText = "";
             } else if (isMouseOver(300, 390, 200, 50)) {
-                if (!current_user.failed_questions.empty()) {
-                    current_user.failed_questions.pop_front();
+                if (!current_user.failed_questions().empty()) {
+                    current_user.remove_first_failed_question();
                 }
                 userInputText = "";
             }
         }
     }
     
-    if (event.type == Event::TextEntered && !current_user.failed_questions.empty()) {
+    if (event.type == Event::TextEntered && !current_user.failed_questions().empty()) {
         if (event.text.unicode == '\b') {
             if (!userInputText.empty()) userInputText.pop_back();
         } else if (event.text.unicode < 128 && event.text.unicode != '\r' && event.text.unicode != '\t') {
@@ -850,9 +2509,7 @@ void handleRetryFailedInput(Event& event) {
 // Start a new level when player clicks
 void handleLevelStartInput(Event& event) {
     if (event.type == Event::MouseButtonPressed && event.mouseButton.button == Mouse::Left) {
-        currentQuestion = generate_random_question(currentLevel + 1);
-        gameClock.restart();
-        currentState = PLAYING_LEVEL;
+        start_question();
     }
 }
 
@@ -864,26 +2521,503 @@ void handleLevelEndInput(Event& event) {
     }
 }
 
+// Compare the old vector<User>/list layout with UserTable at scale.
+// Run with: MathClashGame.exe --bench-users [count]
+void run_user_table_benchmark(size_t count) {
+    struct ListUser {
+        string username;
+        string password;
+        int total_score = 0;
+        int games_played = 0;
+        int games_won = 0;
+        int games_lost = 0;
+        list<Question> failed_questions;
+    };
+    const char* sample_questions[] = {"6 * 4", "12 - 29 * 11", "21 - 37 / 8", "44 * 15 / 15 - 31"};
+
+    vector<ListUser> legacy;
+    vector<Question> legacy_questions;
+    UserTable table;
+    for (size_t i = 0; i < count; ++i) {
+        User u;
+        u.username = "player" + to_string(i);
+        u.password = "pass" + to_string(i % 1000);
+        u.total_score = static_cast<int>((i * 7919) % 5000);
+        u.games_played = static_cast<int>(i % 50);
+        u.games_won = u.games_played / 2;
+        u.games_lost = u.games_played - u.games_won;
+        for (size_t q = 0; q < i % 4; ++q) {
+            Question question;
+            question.expression = sample_questions[(i + q) % 4];
+            question.answer = evaluate_expression(question.expression);
+            pack_expression(question.expression, question.packed);
+            u.failed_questions.push_back(question.packed);
+            legacy_questions.push_back(question);
+        }
+
+        ListUser old{u.username, u.password, u.total_score, u.games_played, u.games_won, u.games_lost, {}};
+        old.failed_questions.assign(legacy_questions.begin(), legacy_questions.end());
+        legacy_questions.clear();
+        legacy.push_back(old);
+        table.add(move(u));
+    }
+
+    auto heap_string = [](const string& str) -> size_t {
+        return str.capacity() > 15 ? str.capacity() + 1 : 0;
+    };
+    size_t legacy_bytes = legacy.capacity() * sizeof(ListUser);
+    for (const auto& u : legacy) {
+        legacy_bytes += heap_string(u.username) + heap_string(u.password);
+        for (const auto& q : u.failed_questions) {
+            legacy_bytes += sizeof(Question) + 2 * sizeof(void*) + heap_string(q.expression);
+        }
+    }
+
+    using BenchClock = chrono::steady_clock;
+    auto millis = [](BenchClock::time_point start) {
+        return chrono::duration<double, milli>(BenchClock::now() - start).count();
+    };
+
+    // The same top-5 selection on both layouts, so only the score scan differs
+    auto top_five = [](vector<ScoreEntry>& entries) {
+        size_t count = min(LEADERBOARD_SIZE, entries.size());
+        partial_sort(entries.begin(), entries.begin() + count, entries.end(), ranks_higher);
+        entries.resize(count);
+    };
+
+    auto start = BenchClock::now();
+    vector<ScoreEntry> leaders;
+    leaders.reserve(legacy.size());
+    for (size_t i = 0; i < legacy.size(); ++i) leaders.push_back({legacy[i].total_score, static_cast<uint32_t>(i)});
+    top_five(leaders);
+    double legacy_scan = millis(start);
+
+    start = BenchClock::now();
+    vector<ScoreEntry> top;
+    top.reserve(table.size());
+    for (size_t i = 0; i < table.size(); ++i) top.push_back({table.total_score[i], static_cast<uint32_t>(i)});
+    top_five(top);
+    double table_scan = millis(start);
+
+    // Serialising every row the way save_users does
+    start = BenchClock::now();
+    ostringstream legacy_out;
+    for (auto& u : legacy) {
+        legacy_out << u.username << " " << u.password << " " << u.total_score << " "
+                   << u.games_played << " " << u.games_won << " " << u.games_lost << " "
+                   << u.failed_questions.size() << "\n";
+        for (auto& q : u.failed_questions) legacy_out << q.expression << "~" << q.answer << "\n";
+    }
+    double legacy_save = millis(start);
+
+    start = BenchClock::now();
+    ostringstream table_out;
+    for (size_t i = 0; i < table.size(); ++i) {
+        table_out << table.username(i) << " " << table.password(i) << " " << table.total_score[i] << " "
+                  << table.games_played[i] << " " << table.games_won[i] << " " << table.games_lost[i] << " "
+                  << table.failed_questions[i].size() << "\n";
+        for (auto& q : table.failed_questions[i]) table_out << "@" << hex << q.bits << dec << "\n";
+    }
+    double table_save = millis(start);
+
+    cout << fixed << setprecision(2);
+    cout << "Users: " << count << "\n";
+    cout << "Memory      vector<User>: " << legacy_bytes / (1024.0 * 1024.0) << " MB"
+         << " | UserTable: " << table.memory_usage() / (1024.0 * 1024.0) << " MB\n";
+    cout << "Leaderboard vector<User>: " << legacy_scan << " ms"
+         << " | UserTable: " << table_scan << " ms"
+         << " (" << count / (table_scan / 1000.0) / 1e6 << " M users/s)\n";
+    cout << "Save loop   vector<User>: " << legacy_save << " ms"
+         << " | UserTable: " << table_save << " ms\n";
+    for (size_t i = 0; i < top.size(); ++i) {
+        if (top[i].row != leaders[i].row || top[i].score != leaders[i].score) {
+            cout << "Leaderboard mismatch between layouts!\n";
+            break;
+        }
+    }
+}
+
+// Stress the score store from every core: each thread mixes score updates
+// with leaderboard reads. A single mutex around a plain score vector with
+// a full scan per read is measured alongside for comparison.
+// Run with: MathClashGame.exe --bench-store [players] [seconds]
+void run_score_store_benchmark(size_t players, double seconds) {
+    unsigned threads = max(1u, min<unsigned>(thread::hardware_concurrency(), SnapshotEpochs::MAX_READERS));
+    const int READ_EVERY = 8;   // one leaderboard read per 8 operations
+
+    vector<int> scores(players);
+    mt19937 seed_rng(42);
+    for (auto& score : scores) score = static_cast<int>(seed_rng() % 5000);
+
+    auto run = [&](auto&& update, auto&& read) {
+        atomic<bool> stop{false};
+        atomic<uint64_t> updates{0}, reads{0};
+        vector<thread> workers;
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t]() {
+                mt19937 rng(t + 1);
+                uint64_t my_updates = 0, my_reads = 0;
+                while (!stop.load(memory_order_relaxed)) {
+                    if (rng() % READ_EVERY == 0) {
+                        read();
+                        my_reads++;
+                    } else {
+                        int delta = static_cast<int>(rng() % 16) - 5;
+                        update(static_cast<uint32_t>(rng() % players), delta);
+                        my_updates++;
+                    }
+                }
+                updates += my_updates;
+                reads += my_reads;
+            });
+        }
+        this_thread::sleep_for(chrono::duration<double>(seconds));
+        stop = true;
+        for (auto& worker : workers) worker.join();
+        cout << updates / seconds / 1e6 << " M updates/s, " << reads / seconds / 1e3 << " K reads/s\n";
+    };
+
+    cout << fixed << setprecision(2);
+    cout << "Players: " << players << ", threads: " << threads << ", " << seconds << " s per run\n";
+
+    ShardedScoreStore store;
+    store.rebuild(scores);
+    vector<atomic<int>> live_scores(players);
+    for (size_t i = 0; i < players; ++i) live_scores[i] = scores[i];
+    cout << "Sharded store:    ";
+    run([&](uint32_t row, int delta) { store.set_score(row, live_scores[row].fetch_add(delta) + delta); },
+        [&]() { store.top(LEADERBOARD_SIZE); });
+
+    mutex global_lock;
+    cout << "Single mutex:     ";
+    run([&](uint32_t row, int delta) {
+            lock_guard<mutex> guard(global_lock);
+            scores[row] += delta;
+        },
+        [&]() {
+            lock_guard<mutex> guard(global_lock);
+            vector<int> best(LEADERBOARD_SIZE, numeric_limits<int>::min());
+            for (int score : scores) {
+                if (score > best.back()) {
+                    best.back() = score;
+                    sort(best.rbegin(), best.rend());
+                }
+            }
+        });
+}
+
+// Time the rank index behind the scrollable leaderboard: building it,
+// score changes, fetching a page at a random rank and finding one
+// player's rank, against sorting every player for each page. The final
+// board is checked against a full sort.
+// Run with: MathClashGame.exe --bench-ranks [players] [operations]
+void run_rank_index_benchmark(size_t players, size_t operations) {
+    using BenchClock = chrono::steady_clock;
+    auto elapsed_ns = [](BenchClock::time_point start) {
+        return chrono::duration<double, nano>(BenchClock::now() - start).count();
+    };
+
+    mt19937 rng(42);
+    vector<int> scores(players);
+    for (auto& score : scores) score = static_cast<int>(rng() % 5000);
+
+    RankIndex index;
+    auto start = BenchClock::now();
+    index.rebuild(scores);
+    double build_ms = elapsed_ns(start) / 1e6;
+
+    start = BenchClock::now();
+    for (size_t i = 0; i < operations; ++i) {
+        uint32_t row = static_cast<uint32_t>(rng() % players);
+        scores[row] += static_cast<int>(rng() % 16) - 5;
+        index.set_score(row, scores[row]);
+    }
+    double update_ns = elapsed_ns(start) / operations;
+
+    size_t checksum = 0;
+    start = BenchClock::now();
+    for (size_t i = 0; i < operations; ++i) {
+        checksum += index.page(rng() % players, LEADERBOARD_ROWS).size();
+    }
+    double page_ns = elapsed_ns(start) / operations;
+
+    start = BenchClock::now();
+    for (size_t i = 0; i < operations; ++i) checksum += index.rank_of(static_cast<uint32_t>(rng() % players));
+    double rank_ns = elapsed_ns(start) / operations;
+
+    // Baseline: materialize and sort the whole board for every page
+    const size_t SORT_ROUNDS = 5;
+    vector<ScoreEntry> sorted;
+    start = BenchClock::now();
+    for (size_t i = 0; i < SORT_ROUNDS; ++i) {
+        sorted.resize(players);
+        for (size_t row = 0; row < players; ++row) sorted[row] = {scores[row], static_cast<uint32_t>(row)};
+        sort(sorted.begin(), sorted.end(), ranks_higher);
+        checksum += sorted[rng() % players].row;
+    }
+    double sort_ns = elapsed_ns(start) / SORT_ROUNDS;
+
+    vector<ScoreEntry> board = index.page(0, players);
+    bool matches = board.size() == sorted.size();
+    for (size_t i = 0; matches && i < board.size(); ++i) {
+        matches = board[i].row == sorted[i].row && board[i].score == sorted[i].score &&
+                  index.rank_of(board[i].row) == i;
+    }
+
+    cout << fixed << setprecision(1);
+    cout << "Players: " << players << ", " << index.blocks.size() << " blocks\n";
+    cout << "Build:          " << build_ms << " ms\n";
+    cout << "Score change:   " << update_ns << " ns\n";
+    cout << "Page of " << LEADERBOARD_ROWS << ":     " << page_ns << " ns\n";
+    cout << "Rank of player: " << rank_ns << " ns\n";
+    cout << "Full sort:      " << sort_ns / 1e3 << " us per page\n";
+    cout << "Board matches full sort: " << (matches ? "yes" : "NO") << " (checksum " << checksum % 1000 << ")\n";
+}
+
+// Measure the seen filter's false-positive rate and what it costs and
+// buys when generating level 1 questions.
+// Run with: MathClashGame.exe --bench-bloom [questions]
+void run_seen_filter_benchmark(size_t questions) {
+    mt19937_64 keys(7);
+    SeenFilter filter;
+    for (uint32_t i = 0; i < 4 * SeenFilter::GENERATION_SIZE; ++i) filter.insert(PackedQuestion{keys()});
+    size_t false_hits = 0;
+    for (size_t i = 0; i < questions; ++i) {
+        PackedQuestion fresh{keys()};
+        false_hits += filter.contains(fresh);
+        filter.insert(fresh);
+    }
+    double fill = 1.0 - exp(-static_cast<double>(SeenFilter::PROBES) * SeenFilter::GENERATION_SIZE / SeenFilter::BITS);
+    double one_generation = pow(fill, SeenFilter::PROBES);
+    double worst = 1.0 - (1.0 - one_generation) * (1.0 - one_generation);
+
+    cout << fixed << setprecision(3);
+    cout << "Seen filter: " << filter.words.size() * sizeof(uint64_t) << " bytes per player, remembers the last "
+         << SeenFilter::GENERATION_SIZE << "-" << 2 * SeenFilter::GENERATION_SIZE << " questions\n";
+    cout << "False positives: " << 100.0 * false_hits / questions << "% measured, "
+         << 100.0 * worst << "% expected with both generations full\n";
+
+    levels = load_levels();
+    const LevelDef& level = levels[0];
+    using BenchClock = chrono::steady_clock;
+    auto run = [&](bool use_filter) {
+        mt19937 rng(11);
+        SeenFilter seen;
+        deque<uint64_t> recent;
+        unordered_map<uint64_t, int> recent_count;
+        size_t repeats = 0;
+        size_t draws = 0;
+        double generate_ns = 0;
+        for (size_t i = 0; i < questions; ++i) {
+            auto start = BenchClock::now();
+            Question q;
+            if (use_filter) {
+                int attempts;
+                q = generate_fresh_question(level, rng, seen, &attempts);
+                seen.insert(q.packed);
+                draws += attempts;
+            } else {
+                q = generate_random_question(level, rng);
+                draws++;
+            }
+            generate_ns += chrono::duration<double, nano>(BenchClock::now() - start).count();
+
+            // Exact check against the last GENERATION_SIZE questions asked
+            if (recent_count[q.packed.bits]++ > 0) repeats++;
+            recent.push_back(q.packed.bits);
+            if (recent.size() > SeenFilter::GENERATION_SIZE) {
+                recent_count[recent.front()]--;
+                recent.pop_front();
+            }
+        }
+        cout << (use_filter ? "Level 1 filtered: " : "Level 1 plain:    ") << setprecision(0) << generate_ns / questions
+             << " ns/question, " << setprecision(2) << 100.0 * repeats / questions << "% repeat one of the last "
+             << SeenFilter::GENERATION_SIZE << ", " << static_cast<double>(draws) / questions << " draws each\n";
+    };
+    run(false);
+    run(true);
+}
+
+// Push many logins through worker pools of growing size while a loop
+// stands in for the render thread, polling once per simulated frame.
+// Run with: MathClashGame.exe --bench-login [logins] [max workers]
+void run_login_benchmark(size_t logins, unsigned max_workers) {
+    using BenchClock = chrono::steady_clock;
+    const int ACCOUNTS = 8;
+    vector<string> stored;
+    for (int i = 0; i < ACCOUNTS; ++i) stored.push_back(hash_password("pass" + to_string(i)));
+
+    auto start = BenchClock::now();
+    verify_password("pass0", stored[0]);
+    cout << fixed << setprecision(1) << "One scrypt check (N=2^" << PASSWORD_LOG2_N << ", r=" << PASSWORD_R
+         << "): " << chrono::duration<double, milli>(BenchClock::now() - start).count() << " ms\n";
+
+    for (unsigned workers = 1; workers <= max_workers; workers *= 2) {
+        LoginWorkers pool;
+        pool.start(workers);
+        size_t submitted = 0, collected = 0, accepted = 0;
+        double longest_frame_ms = 0;
+
+        start = BenchClock::now();
+        while (collected < logins) {
+            auto frame = BenchClock::now();
+            while (submitted < logins) {
+                // Every fourth attempt uses a wrong password
+                int account = static_cast<int>(submitted % ACCOUNTS);
+                string typed = submitted % 4 == 3 ? "wrong" : "pass" + to_string(account);
+                if (!pool.submit({LoginWorkers::LOGIN, account, "player" + to_string(account), typed, stored[account]})) break;
+                submitted++;
+            }
+            LoginWorkers::Result result;
+            while (pool.poll(result)) {
+                collected++;
+                accepted += result.ok;
+            }
+            longest_frame_ms = max(longest_frame_ms, chrono::duration<double, milli>(BenchClock::now() - frame).count());
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        double seconds = chrono::duration<double>(BenchClock::now() - start).count();
+        pool.stop();
+
+        cout << setw(2) << workers << " worker(s): " << logins / seconds << " logins/s, " << accepted << "/" << logins
+             << " accepted, longest poll " << setprecision(3) << longest_frame_ms << " ms\n" << setprecision(1);
+    }
+}
+
+// Time the exact grader against the old stod/try-catch/tolerance path on
+// valid answers and on garbage input.
+// Run with: MathClashGame.exe --bench-grader [rounds]
+void run_grader_benchmark(size_t rounds) {
+    auto legacy_is_answer_correct = [](const string& input, double correct) {
+        auto parse = [](const string& text) {
+            size_t slash = text.find('/');
+            if (slash != string::npos) {
+                try {
+                    double num = stod(text.substr(0, slash));
+                    double den = stod(text.substr(slash + 1));
+                    if (abs(den) < 1e-9) return numeric_limits<double>::infinity();
+                    return num / den;
+                } catch (...) {
+                    return numeric_limits<double>::quiet_NaN();
+                }
+            }
+            return stod(text);
+        };
+        double typed;
+        try {
+            typed = parse(input);
+        } catch (...) {
+            return false;
+        }
+        if (fabs(typed - correct) < 0.1) return true;
+        return fabs(correct - floor(correct)) < 0.01 && fabs(typed - floor(correct)) < 0.01;
+    };
+
+    PackedQuestion question;
+    pack_expression("21 - 37 / 8", question);
+    double answer = evaluate_expression("21 - 37 / 8");
+    const vector<string> valid = {"16.375", "131/8", "16.375000", " 16.375 "};
+    const vector<string> garbage = {"abc", "", "16,375", "1/x", "--3", "s"};
+
+    using BenchClock = chrono::steady_clock;
+    auto time_ns = [&](const vector<string>& inputs, auto&& grade) {
+        size_t accepted = 0;
+        auto start = BenchClock::now();
+        for (size_t r = 0; r < rounds; ++r) {
+            for (const auto& input : inputs) accepted += grade(input);
+        }
+        double ns = chrono::duration<double, nano>(BenchClock::now() - start).count();
+        return make_pair(ns / (rounds * inputs.size()), accepted);
+    };
+
+    auto legacy = [&](const string& input) { return legacy_is_answer_correct(input, answer); };
+    auto exact = [&](const string& input) { return is_answer_correct(input, question); };
+
+    cout << fixed << setprecision(1);
+    for (auto& group : {make_pair("valid", &valid), make_pair("garbage", &garbage)}) {
+        auto old_result = time_ns(*group.second, legacy);
+        auto new_result = time_ns(*group.second, exact);
+        cout << setw(8) << group.first << " answers: old " << old_result.first << " ns"
+             << " | exact " << new_result.first << " ns"
+             << " (accepted " << old_result.second / rounds << " vs " << new_result.second / rounds
+             << " of " << group.second->size() << ")\n";
+    }
+}
+
 // Main game loop - keeps everything running
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc >= 2 && string(argv[1]) == "--bench-users") {
+        run_user_table_benchmark(argc >= 3 ? stoul(argv[2]) : 1000000);
+        return 0;
+    }
+    if (argc >= 2 && string(argv[1]) == "--bench-grader") {
+        run_grader_benchmark(argc >= 3 ? stoul(argv[2]) : 200000);
+        return 0;
+    }
+    if (argc >= 2 && string(argv[1]) == "--bench-bloom") {
+        run_seen_filter_benchmark(argc >= 3 ? stoul(argv[2]) : 1000000);
+        return 0;
+    }
+    if (argc >= 2 && string(argv[1]) == "--bench-login") {
+        run_login_benchmark(argc >= 3 ? stoul(argv[2]) : 64,
+                            argc >= 4 ? stoul(argv[3]) : max(1u, thread::hardware_concurrency()));
+        return 0;
+    }
+    if (argc >= 2 && string(argv[1]) == "--bench-ranks") {
+        run_rank_index_benchmark(argc >= 3 ? stoul(argv[2]) : 1000000, argc >= 4 ? stoul(argv[3]) : 1000000);
+        return 0;
+    }
+    if (argc >= 2 && string(argv[1]) == "--bench-store") {
+        run_score_store_benchmark(argc >= 3 ? stoul(argv[2]) : 1000000, argc >= 4 ? stod(argv[3]) : 2.0);
+        return 0;
+    }
+
     cout << "Starting Math Clash Game..." << endl;
+    auto startupTime = chrono::steady_clock::now();
     
     window = new RenderWindow(VideoMode(800, 600), "Math Clash Game");
     window->setFramerateLimit(60);
     
-    graphics_mode = loadResources();
-    if (!graphics_mode) {
-        cout << "Running in console mode only." << endl;
-    }
+    // Fonts and images load in the background while a placeholder is drawn
+    pendingAssets = async(launch::async, load_assets);
+    bool assetsReady = false;
+    bool startupFinished = false;
+    bool firstFrameShown = false;
+    Clock loadingClock;
     
-    initialize_rng();
-    load_users();
+    login_workers.start(LOGIN_WORKER_COUNT);
+    
+    // Levels, the stats segment, player headers, journals and rank tables are
+    // built off the render thread; nothing below touches them until gameDataReady
+    pendingGameData = async(launch::async, load_game_data);
+    bool gameDataReady = false;
     
     while (window->isOpen()) {
+        if (!assetsReady && pendingAssets.wait_for(chrono::seconds(0)) == future_status::ready) {
+            graphics_mode = apply_assets(pendingAssets.get());
+            if (!graphics_mode) {
+                cout << "Running in console mode only." << endl;
+            }
+            assetsReady = true;
+        }
+        if (!gameDataReady && pendingGameData.wait_for(chrono::seconds(0)) == future_status::ready) {
+            pendingGameData.get();
+            gameDataReady = true;
+        }
+        bool ready = assetsReady && gameDataReady;
+        if (ready && !startupFinished) {
+            startupFinished = true;
+            cout << "Startup finished after "
+                 << chrono::duration<double, milli>(chrono::steady_clock::now() - startupTime).count() << " ms" << endl;
+        }
+
+        if (ready) handleLoginResults();
+
         Event event;
         while (window->pollEvent(event)) {
             if (event.type == Event::Closed)
                 window->close();
+            if (!ready) continue;
             
             switch (currentState) {
                 case AUTH_MENU:
@@ -915,68 +3049,70 @@ int main() {
         
         window->clear(Color(20, 20, 40));
         
-        switch (currentState) {
-            case AUTH_MENU:
-                drawAuthMenu();
-                break;
-            case MAIN_MENU:
-                drawMainMenu();
-                break;
-            case PLAYING_LEVEL:
-                drawGameLevel();
-                break;
-            case DASHBOARD:
-                drawDashboard();
-                break;
-            case LEADERBOARD:
-                drawLeaderboard();
-                break;
-            case RETRY_FAILED:
-                drawRetryFailed();
-                break;
-            case LEVEL_START:
-                drawLevelStart();
-                break;
-            case LEVEL_END:
-                drawLevelEnd();
-                break;
+        if (!ready) {
+            drawLoadingScreen(loadingClock.getElapsedTime().asSeconds());
+        } else {
+            switch (currentState) {
+                case AUTH_MENU:
+                    drawAuthMenu();
+                    break;
+                case MAIN_MENU:
+                    drawMainMenu();
+                    break;
+                case PLAYING_LEVEL:
+                    drawGameLevel();
+                    break;
+                case DASHBOARD:
+                    drawDashboard();
+                    break;
+                case LEADERBOARD:
+                    drawLeaderboard();
+                    break;
+                case RETRY_FAILED:
+                    drawRetryFailed();
+                    break;
+                case LEVEL_START:
+                    drawLevelStart();
+                    break;
+                case LEVEL_END:
+                    drawLevelEnd();
+                    break;
+            }
         }
         
         window->display();
+        if (ready) {
+            windowed_scores.tick(time(nullptr));
+            finish_users_compaction(false);
+        }
+        if (!firstFrameShown) {
+            firstFrameShown = true;
+            cout << "First frame after "
+                 << chrono::duration<double, milli>(chrono::steady_clock::now() - startupTime).count() << " ms" << endl;
+        }
         
-        if (currentState == PLAYING_LEVEL) {
-            vector<int> levelTimes = {20, 15, 10};
-            int timeLimit = levelTimes[currentLevel];
+        if (ready && currentState == PLAYING_LEVEL) {
+            int timeLimit = levels[currentLevel].time_limit;
             float elapsed = gameClock.getElapsedTime().asSeconds();
             
             if (elapsed >= timeLimit && !timeUp) {
                 timeUp = true;
-                current_user.failed_questions.push_back(currentQuestion);
-                current_user.total_score -= 5;
+                current_user.add_failed_question(currentQuestion.packed);
+                current_user.add_score(-5);
                 levelScore -= 5;
                 
                 this_thread::sleep_for(chrono::seconds(2));
-                userInputText = "";
-                currentLevel++;
-                
-                if (currentLevel < 3) {
-                    currentState = LEVEL_START;
-                } else {
-                    if (levelScore > 0) {
-                        levelMessage = "LEVEL PASSED! ";
-                        current_user.games_won++;
-                    } else {
-                        levelMessage = "LEVEL FAILED! ";
-                        current_user.games_lost++;
-                    }
-                    current_user.games_played++;
-                    currentState = LEVEL_END;
-                }
+                finish_question();
             }
         }
     }
     
+    // Closed during loading: let the loader finish before anything is saved
+    if (!gameDataReady) pendingGameData.get();
+    login_workers.stop();
     save_users();
+    compact_users_file();
+    stats_export.close();
     delete window;
     
     return 0;
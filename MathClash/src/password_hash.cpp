@@ -0,0 +1,319 @@
+// scrypt (RFC 7914) on top of PBKDF2-HMAC-SHA256 (RFC 8018, FIPS 180-4)
+#include "password_hash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+struct Sha256 {
+    uint32_t state[8];
+    uint8_t block[64];
+    size_t block_used;
+    uint64_t total_bytes;
+
+    Sha256() { reset(); }
+
+    void reset() {
+        static const uint32_t initial[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                            0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+        memcpy(state, initial, sizeof(state));
+        block_used = 0;
+        total_bytes = 0;
+    }
+
+    void update(const uint8_t* data, size_t size) {
+        total_bytes += size;
+        while (size > 0) {
+            size_t take = std::min(size, sizeof(block) - block_used);
+            memcpy(block + block_used, data, take);
+            block_used += take;
+            data += take;
+            size -= take;
+            if (block_used == sizeof(block)) {
+                compress(block);
+                block_used = 0;
+            }
+        }
+    }
+
+    void finish(uint8_t out[32]) {
+        uint64_t bits = total_bytes * 8;
+        uint8_t pad = 0x80;
+        update(&pad, 1);
+        pad = 0;
+        while (block_used != 56) update(&pad, 1);
+        uint8_t length[8];
+        for (int i = 0; i < 8; ++i) length[i] = static_cast<uint8_t>(bits >> (56 - 8 * i));
+        update(length, 8);
+        for (int i = 0; i < 8; ++i) {
+            out[4 * i] = static_cast<uint8_t>(state[i] >> 24);
+            out[4 * i + 1] = static_cast<uint8_t>(state[i] >> 16);
+            out[4 * i + 2] = static_cast<uint8_t>(state[i] >> 8);
+            out[4 * i + 3] = static_cast<uint8_t>(state[i]);
+        }
+    }
+
+    static uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+    void compress(const uint8_t* chunk) {
+        static const uint32_t k[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+        uint32_t w[64];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = (static_cast<uint32_t>(chunk[4 * i]) << 24) | (static_cast<uint32_t>(chunk[4 * i + 1]) << 16) |
+                   (static_cast<uint32_t>(chunk[4 * i + 2]) << 8) | chunk[4 * i + 3];
+        }
+        for (int i = 16; i < 64; ++i) {
+            uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; ++i) {
+            uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+            uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+};
+
+// PBKDF2-HMAC-SHA256. The keyed inner and outer states are computed once
+// and copied for every HMAC instead of re-absorbing the padded key.
+static void pbkdf2_sha256(const uint8_t* password, size_t password_size, const uint8_t* salt, size_t salt_size,
+                          uint32_t iterations, uint8_t* out, size_t out_size) {
+    uint8_t key[64] = {};
+    if (password_size > sizeof(key)) {
+        Sha256 key_hash;
+        key_hash.update(password, password_size);
+        key_hash.finish(key);
+    } else {
+        memcpy(key, password, password_size);
+    }
+
+    uint8_t pad[64];
+    Sha256 inner, outer;
+    for (int i = 0; i < 64; ++i) pad[i] = key[i] ^ 0x36;
+    inner.update(pad, 64);
+    for (int i = 0; i < 64; ++i) pad[i] = key[i] ^ 0x5c;
+    outer.update(pad, 64);
+
+    auto hmac = [&](const uint8_t* first, size_t first_size, const uint8_t* second, size_t second_size,
+                    uint8_t result[32]) {
+        Sha256 h = inner;
+        h.update(first, first_size);
+        h.update(second, second_size);
+        uint8_t inner_digest[32];
+        h.finish(inner_digest);
+        h = outer;
+        h.update(inner_digest, 32);
+        h.finish(result);
+    };
+
+    for (uint32_t block = 1; out_size > 0; ++block) {
+        uint8_t counter[4] = {static_cast<uint8_t>(block >> 24), static_cast<uint8_t>(block >> 16),
+                              static_cast<uint8_t>(block >> 8), static_cast<uint8_t>(block)};
+        uint8_t u[32], t[32];
+        hmac(salt, salt_size, counter, 4, u);
+        memcpy(t, u, 32);
+        for (uint32_t i = 1; i < iterations; ++i) {
+            hmac(u, 32, nullptr, 0, u);
+            for (int j = 0; j < 32; ++j) t[j] ^= u[j];
+        }
+        size_t take = std::min<size_t>(out_size, 32);
+        memcpy(out, t, take);
+        out += take;
+        out_size -= take;
+    }
+}
+
+static inline uint32_t rotl(uint32_t x, int n) { return (x << n) | (x >> (32 - n)); }
+
+// Salsa20/8 core, applied in place to one 64-byte block
+static void salsa20_8(uint32_t b[16]) {
+    uint32_t x[16];
+    memcpy(x, b, sizeof(x));
+    for (int round = 0; round < 8; round += 2) {
+        x[4] ^= rotl(x[0] + x[12], 7);   x[8] ^= rotl(x[4] + x[0], 9);
+        x[12] ^= rotl(x[8] + x[4], 13);  x[0] ^= rotl(x[12] + x[8], 18);
+        x[9] ^= rotl(x[5] + x[1], 7);    x[13] ^= rotl(x[9] + x[5], 9);
+        x[1] ^= rotl(x[13] + x[9], 13);  x[5] ^= rotl(x[1] + x[13], 18);
+        x[14] ^= rotl(x[10] + x[6], 7);  x[2] ^= rotl(x[14] + x[10], 9);
+        x[6] ^= rotl(x[2] + x[14], 13);  x[10] ^= rotl(x[6] + x[2], 18);
+        x[3] ^= rotl(x[15] + x[11], 7);  x[7] ^= rotl(x[3] + x[15], 9);
+        x[11] ^= rotl(x[7] + x[3], 13);  x[15] ^= rotl(x[11] + x[7], 18);
+
+        x[1] ^= rotl(x[0] + x[3], 7);    x[2] ^= rotl(x[1] + x[0], 9);
+        x[3] ^= rotl(x[2] + x[1], 13);   x[0] ^= rotl(x[3] + x[2], 18);
+        x[6] ^= rotl(x[5] + x[4], 7);    x[7] ^= rotl(x[6] + x[5], 9);
+        x[4] ^= rotl(x[7] + x[6], 13);   x[5] ^= rotl(x[4] + x[7], 18);
+        x[11] ^= rotl(x[10] + x[9], 7);  x[8] ^= rotl(x[11] + x[10], 9);
+        x[9] ^= rotl(x[8] + x[11], 13);  x[10] ^= rotl(x[9] + x[8], 18);
+        x[12] ^= rotl(x[15] + x[14], 7); x[13] ^= rotl(x[12] + x[15], 9);
+        x[14] ^= rotl(x[13] + x[12], 13); x[15] ^= rotl(x[14] + x[13], 18);
+    }
+    for (int i = 0; i < 16; ++i) b[i] += x[i];
+}
+
+// scryptBlockMix: in and out are 2r blocks of 16 words
+static void block_mix(const uint32_t* in, uint32_t* out, uint32_t r) {
+    uint32_t x[16];
+    memcpy(x, in + (2 * r - 1) * 16, sizeof(x));
+    for (uint32_t i = 0; i < 2 * r; ++i) {
+        for (int j = 0; j < 16; ++j) x[j] ^= in[i * 16 + j];
+        salsa20_8(x);
+        // Even blocks go to the first half of the output, odd ones to the second
+        memcpy(out + ((i & 1) * r + i / 2) * 16, x, sizeof(x));
+    }
+}
+
+// scryptROMix over one 128r-byte chunk of B
+static void ro_mix(uint8_t* chunk, uint32_t r, uint64_t n, std::vector<uint32_t>& v) {
+    const size_t words = 32 * r;
+    std::vector<uint32_t> x(words), y(words);
+    for (size_t i = 0; i < words; ++i) {
+        x[i] = static_cast<uint32_t>(chunk[4 * i]) | (static_cast<uint32_t>(chunk[4 * i + 1]) << 8) |
+               (static_cast<uint32_t>(chunk[4 * i + 2]) << 16) | (static_cast<uint32_t>(chunk[4 * i + 3]) << 24);
+    }
+
+    for (uint64_t i = 0; i < n; ++i) {
+        memcpy(&v[i * words], x.data(), words * sizeof(uint32_t));
+        block_mix(x.data(), y.data(), r);
+        x.swap(y);
+    }
+    for (uint64_t i = 0; i < n; ++i) {
+        uint64_t j = x[(2 * r - 1) * 16] & (n - 1);
+        const uint32_t* row = &v[j * words];
+        for (size_t k = 0; k < words; ++k) x[k] ^= row[k];
+        block_mix(x.data(), y.data(), r);
+        x.swap(y);
+    }
+
+    for (size_t i = 0; i < words; ++i) {
+        chunk[4 * i] = static_cast<uint8_t>(x[i]);
+        chunk[4 * i + 1] = static_cast<uint8_t>(x[i] >> 8);
+        chunk[4 * i + 2] = static_cast<uint8_t>(x[i] >> 16);
+        chunk[4 * i + 3] = static_cast<uint8_t>(x[i] >> 24);
+    }
+}
+
+std::vector<uint8_t> scrypt(const std::string& password, const std::vector<uint8_t>& salt,
+                            uint64_t n, uint32_t r, uint32_t p, size_t key_bytes) {
+    const uint8_t* pass = reinterpret_cast<const uint8_t*>(password.data());
+    std::vector<uint8_t> b(static_cast<size_t>(p) * 128 * r);
+    pbkdf2_sha256(pass, password.size(), salt.data(), salt.size(), 1, b.data(), b.size());
+
+    std::vector<uint32_t> v(static_cast<size_t>(n) * 32 * r);
+    for (uint32_t i = 0; i < p; ++i) ro_mix(&b[static_cast<size_t>(i) * 128 * r], r, n, v);
+
+    std::vector<uint8_t> key(key_bytes);
+    pbkdf2_sha256(pass, password.size(), b.data(), b.size(), 1, key.data(), key.size());
+    return key;
+}
+
+static std::string to_hex(const std::vector<uint8_t>& bytes) {
+    static const char digits[] = "0123456789abcdef";
+    std::string text;
+    for (uint8_t byte : bytes) {
+        text += digits[byte >> 4];
+        text += digits[byte & 15];
+    }
+    return text;
+}
+
+static bool from_hex(const std::string& text, std::vector<uint8_t>& out) {
+    auto digit = [](char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    };
+    if (text.empty() || text.size() % 2 != 0) return false;
+    out.clear();
+    for (size_t i = 0; i < text.size(); i += 2) {
+        int high = digit(text[i]), low = digit(text[i + 1]);
+        if (high < 0 || low < 0) return false;
+        out.push_back(static_cast<uint8_t>(high * 16 + low));
+    }
+    return true;
+}
+
+std::string hash_password(const std::string& password) {
+    std::random_device device;
+    std::vector<uint8_t> salt(PASSWORD_SALT_BYTES);
+    for (auto& byte : salt) byte = static_cast<uint8_t>(device());
+
+    std::vector<uint8_t> key = scrypt(password, salt, 1ULL << PASSWORD_LOG2_N, PASSWORD_R, PASSWORD_P, PASSWORD_KEY_BYTES);
+    return "$scrypt$" + std::to_string(PASSWORD_LOG2_N) + "$" + std::to_string(PASSWORD_R) + "$" +
+           std::to_string(PASSWORD_P) + "$" + to_hex(salt) + "$" + to_hex(key);
+}
+
+bool is_password_hash(const std::string& stored) {
+    return stored.compare(0, 8, "$scrypt$") == 0;
+}
+
+// Equal-length comparison whose time does not depend on where bytes differ
+static bool same_bytes(const uint8_t* a, const uint8_t* b, size_t size) {
+    uint8_t diff = 0;
+    for (size_t i = 0; i < size; ++i) diff |= a[i] ^ b[i];
+    return diff == 0;
+}
+
+bool verify_password(const std::string& password, const std::string& stored) {
+    if (!is_password_hash(stored)) {
+        // Record from before hashing; it is rehashed after a successful login
+        std::vector<uint8_t> typed(password.begin(), password.end());
+        std::vector<uint8_t> expected(stored.begin(), stored.end());
+        typed.resize(std::max(typed.size(), expected.size()));
+        expected.resize(typed.size());
+        return same_bytes(typed.data(), expected.data(), typed.size()) & (password.size() == stored.size());
+    }
+
+    // "$scrypt$log2n$r$p$salt$key" splits into 7 fields, the first empty
+    std::vector<std::string> fields(1);
+    for (char c : stored) {
+        if (c == '$') fields.emplace_back();
+        else fields.back() += c;
+    }
+    if (fields.size() != 7) return false;
+
+    int log2_n, r, p;
+    std::vector<uint8_t> salt, key;
+    try {
+        log2_n = std::stoi(fields[2]);
+        r = std::stoi(fields[3]);
+        p = std::stoi(fields[4]);
+    } catch (...) {
+        return false;
+    }
+    if (log2_n < 1 || log2_n > 20 || r < 1 || r > 32 || p < 1 || p > 16 ||
+        !from_hex(fields[5], salt) || !from_hex(fields[6], key) || key.size() > 64) {
+        return false;
+    }
+
+    std::vector<uint8_t> computed = scrypt(password, salt, 1ULL << log2_n, r, p, key.size());
+    return same_bytes(computed.data(), key.data(), key.size());
+}
@@ -0,0 +1,32 @@
+// Salted, memory-hard password hashing for users.txt: scrypt (RFC 7914).
+// Stored form: $scrypt$<log2 N>$<r>$<p>$<salt hex>$<key hex>
+//
+// SHA-256, HMAC, PBKDF2 and Salsa20/8 are implemented in password_hash.cpp
+// so the build needs nothing beyond SFML. A hash takes tens of
+// milliseconds on purpose, so callers keep it off the render thread.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+const int PASSWORD_LOG2_N = 14;            // 16 MB of scratch memory per hash
+const uint32_t PASSWORD_R = 8;
+const uint32_t PASSWORD_P = 1;
+const size_t PASSWORD_SALT_BYTES = 16;
+const size_t PASSWORD_KEY_BYTES = 32;
+
+// Raw scrypt with explicit parameters; n must be a power of two
+std::vector<uint8_t> scrypt(const std::string& password, const std::vector<uint8_t>& salt,
+                            uint64_t n, uint32_t r, uint32_t p, size_t key_bytes);
+
+// Hash with a fresh random salt and the default parameters
+std::string hash_password(const std::string& password);
+
+// True for the "$scrypt$..." form; anything else is an old plaintext record
+bool is_password_hash(const std::string& stored);
+
+// Check a typed password against a stored hash or, for records written
+// before hashing existed, the plaintext. Compares in constant time.
+bool verify_password(const std::string& password, const std::string& stored);
@@ -0,0 +1,508 @@
+// Question generation, evaluation and grading (see questions.h)
+#include "questions.h"
+
+#include <cctype>
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <stack>
+#include <system_error>
+
+using namespace std;
+
+// Math expression evaluation helpers
+static int precedence(char op) {
+    if (op == '+' || op == '-') return 1;
+    if (op == '*' || op == '/') return 2;
+    return 0;
+}
+
+// Perform actual math operations
+static double applyOp(double a, double b, char op) {
+    switch (op) {
+        case '+': return a + b;
+        case '-': return a - b;
+        case '*': return a * b;
+        case '/': 
+            return (abs(b) < 1e-9) ? 1e99 : a / b;
+    }
+    return 0;
+}
+
+// Calculate answer for math expressions
+double evaluate_expression(const string& expr) {
+    stack<double> values;
+    stack<char> ops;
+
+    for (int i = 0; i < expr.size(); ++i) {
+        if (expr[i] == ' ') continue;
+
+        if (isdigit(expr[i])) {
+            double val = 0;
+            while (i < expr.size() && isdigit(expr[i])) {
+                val = val * 10 + (expr[i] - '0');
+                i++;
+            }
+            i--;
+            values.push(val);
+        } else {
+            char op = expr[i];
+            while (!ops.empty() && precedence(ops.top()) >= precedence(op)) {
+                double val2 = values.top(); values.pop();
+                double val1 = values.top(); values.pop();
+                char top_op = ops.top(); ops.pop();
+                values.push(applyOp(val1, val2, top_op));
+            }
+            ops.push(op);
+        }
+    }
+
+    while (!ops.empty()) {
+        double val2 = values.top(); values.pop();
+        double val1 = values.top(); values.pop();
+        char op = ops.top(); ops.pop();
+        values.push(applyOp(val1, val2, op));
+    }
+
+    return values.top();
+}
+
+// Squeeze a "a op b op c" expression into a PackedQuestion.
+// Returns false when it has too many operators or an operand out of range.
+bool pack_expression(const string& expr, PackedQuestion& out) {
+    static const string op_chars = "+-*/";
+    uint64_t bits = 0;
+    int operands = 0;
+    int operators = 0;
+    bool expect_operand = true;
+
+    for (size_t i = 0; i < expr.size(); ++i) {
+        if (expr[i] == ' ') continue;
+
+        if (isdigit(static_cast<unsigned char>(expr[i]))) {
+            if (!expect_operand || operands > PackedQuestion::MAX_OPERATORS) return false;
+            int val = 0;
+            while (i < expr.size() && isdigit(static_cast<unsigned char>(expr[i]))) {
+                val = val * 10 + (expr[i] - '0');
+                if (val > PackedQuestion::MAX_OPERAND) return false;
+                i++;
+            }
+            i--;
+            bits |= static_cast<uint64_t>(val) << (10 + 10 * operands);
+            operands++;
+            expect_operand = false;
+        } else {
+            size_t op = op_chars.find(expr[i]);
+            if (op == string::npos || expect_operand || operators >= PackedQuestion::MAX_OPERATORS) return false;
+            bits |= static_cast<uint64_t>(op) << (2 + 2 * operators);
+            operators++;
+            expect_operand = true;
+        }
+    }
+
+    if (operators == 0 || expect_operand) return false;
+    out.bits = bits | static_cast<uint64_t>(operators - 1);
+    return true;
+}
+
+// Rebuild the readable expression and its answer from a packed question
+Question materialize_question(PackedQuestion packed) {
+    Question q;
+    q.packed = packed;
+    q.expression = to_string(packed.operand(0));
+    for (int i = 0; i < packed.operator_count(); ++i) {
+        q.expression += ' ';
+        q.expression += packed.op(i);
+        q.expression += ' ';
+        q.expression += to_string(packed.operand(i + 1));
+    }
+    q.answer = evaluate_expression(q.expression);
+    return q;
+}
+
+// Build a reduced Rational; fails if it does not fit in 64 bits
+bool make_rational(__int128 num, __int128 den, Rational& out) {
+    if (den == 0) return false;
+    if (den < 0) {
+        num = -num;
+        den = -den;
+    }
+
+    const __int128 limit = numeric_limits<int64_t>::max();
+    if (num <= limit && num >= -limit && den <= limit) {
+        // Common case: 64-bit gcd is far cheaper than 128-bit division
+        int64_t n = static_cast<int64_t>(num);
+        int64_t d = static_cast<int64_t>(den);
+        int64_t g = gcd(n, d);
+        out.num = n / g;
+        out.den = d / g;
+        return true;
+    }
+
+    __int128 a = num < 0 ? -num : num;
+    __int128 b = den;
+    while (b != 0) {
+        __int128 t = a % b;
+        a = b;
+        b = t;
+    }
+    num /= a;
+    den /= a;
+    if (num > limit || num < -limit || den > limit) return false;
+    out.num = static_cast<int64_t>(num);
+    out.den = static_cast<int64_t>(den);
+    return true;
+}
+
+static bool apply_rational_op(const Rational& a, const Rational& b, char op, Rational& out) {
+    __int128 an = a.num, ad = a.den, bn = b.num, bd = b.den;
+    switch (op) {
+        case '+': return make_rational(an * bd + bn * ad, ad * bd, out);
+        case '-': return make_rational(an * bd - bn * ad, ad * bd, out);
+        case '*': return make_rational(an * bn, ad * bd, out);
+        case '/': return make_rational(an * bd, ad * bn, out);
+    }
+    return false;
+}
+
+// Exact value of a packed question, honouring * and / before + and -
+bool evaluate_exact(PackedQuestion q, Rational& out) {
+    Rational sum{0, 1};
+    char sum_op = '+';
+    Rational term{q.operand(0), 1};
+
+    for (int i = 0; i < q.operator_count(); ++i) {
+        char op = q.op(i);
+        Rational next{q.operand(i + 1), 1};
+        if (op == '*' || op == '/') {
+            if (!apply_rational_op(term, next, op, term)) return false;
+        } else {
+            if (!apply_rational_op(sum, term, sum_op, sum)) return false;
+            sum_op = op;
+            term = next;
+        }
+    }
+    return apply_rational_op(sum, term, sum_op, out);
+}
+
+// Parse an unsigned run of digits; no allocation, no exceptions
+static bool parse_digits(string_view text, int64_t& out) {
+    if (text.empty() || !isdigit(static_cast<unsigned char>(text[0]))) return false;
+    auto result = from_chars(text.data(), text.data() + text.size(), out);
+    return result.ec == errc() && result.ptr == text.data() + text.size();
+}
+
+// Parse an optionally signed whole number
+static bool parse_integer(string_view text, int64_t& out) {
+    bool negative = false;
+    if (!text.empty() && (text[0] == '-' || text[0] == '+')) {
+        negative = text[0] == '-';
+        text.remove_prefix(1);
+    }
+    if (!parse_digits(text, out)) return false;
+    if (negative) out = -out;
+    return true;
+}
+
+string_view trim_spaces(string_view text) {
+    while (!text.empty() && isspace(static_cast<unsigned char>(text.front()))) text.remove_prefix(1);
+    while (!text.empty() && isspace(static_cast<unsigned char>(text.back()))) text.remove_suffix(1);
+    return text;
+}
+
+// Read a typed answer: "12", "-3", "16.375", ".5" or "33/2".
+// decimals is set to the number of digits typed after a decimal point.
+bool parse_answer(string_view input, Rational& out, int& decimals) {
+    input = trim_spaces(input);
+    decimals = 0;
+
+    size_t slash = input.find('/');
+    if (slash != string_view::npos) {
+        int64_t num, den;
+        if (!parse_integer(trim_spaces(input.substr(0, slash)), num) ||
+            !parse_integer(trim_spaces(input.substr(slash + 1)), den)) {
+            return false;
+        }
+        return make_rational(num, den, out);
+    }
+
+    size_t dot = input.find('.');
+    if (dot == string_view::npos) {
+        int64_t whole;
+        if (!parse_integer(input, whole)) return false;
+        out = Rational{whole, 1};
+        return true;
+    }
+
+    string_view whole_part = input.substr(0, dot);
+    string_view fraction = input.substr(dot + 1);
+    bool negative = !whole_part.empty() && whole_part[0] == '-';
+    if (!whole_part.empty() && (whole_part[0] == '-' || whole_part[0] == '+')) whole_part.remove_prefix(1);
+    if ((whole_part.empty() && fraction.empty()) || fraction.size() > 18) return false;
+
+    int64_t whole = 0;
+    int64_t digits = 0;
+    // The sign is already gone, so both parts must be bare digits
+    if (!whole_part.empty() && !parse_digits(whole_part, whole)) return false;
+    if (!fraction.empty() && !parse_digits(fraction, digits)) return false;
+
+    __int128 scale = 1;
+    for (size_t i = 0; i < fraction.size(); ++i) scale *= 10;
+    __int128 value = whole * scale + digits;
+    decimals = static_cast<int>(fraction.size());
+    return make_rational(negative ? -value : value, scale, out);
+}
+
+// True when value can be written exactly as a finite decimal
+static bool has_finite_decimal(Rational value) {
+    int64_t den = value.den;
+    while (den % 2 == 0) den /= 2;
+    while (den % 5 == 0) den /= 5;
+    return den == 1;
+}
+
+// Check if user's answer matches the correct one. Compared exactly as
+// fractions. Only when the answer has no finite decimal (7/3) is a decimal
+// accepted within half a unit of its last typed digit, so "2.33" counts.
+bool is_answer_correct(string_view user_input, PackedQuestion question) {
+    Rational typed, correct;
+    int decimals;
+    if (!parse_answer(user_input, typed, decimals) || !evaluate_exact(question, correct)) {
+        return false;
+    }
+
+    // |typed - correct| * 2 * 10^decimals <= 1, all in integers
+    __int128 diff_num = static_cast<__int128>(typed.num) * correct.den - static_cast<__int128>(correct.num) * typed.den;
+    if (diff_num == 0) return true;
+    if (decimals == 0 || has_finite_decimal(correct)) return false;
+
+    __int128 diff_den = static_cast<__int128>(typed.den) * correct.den;
+    if (diff_num < 0) diff_num = -diff_num;
+    __int128 scale = 2;
+    for (int i = 0; i < decimals; ++i) scale *= 10;
+    return diff_num * scale <= diff_den;
+}
+
+// Evaluate operands[0] ops[0] operands[1] ... with * and / before + and -,
+// in the same order and double arithmetic as evaluate_expression().
+// Ops > 0 fixes the operator count at compile time so the loop unrolls;
+// Ops == 0 is the generic version that reads it from count.
+template <int Ops>
+double evaluate_terms(const int* operands, const char* ops, int count) {
+    const int n = Ops > 0 ? Ops : count;
+    double sum = 0;
+    char sum_op = '+';
+    double term = operands[0];
+    for (int i = 0; i < n; ++i) {
+        if (ops[i] == '*' || ops[i] == '/') {
+            term = applyOp(term, operands[i + 1], ops[i]);
+        } else {
+            sum = applyOp(sum, term, sum_op);
+            sum_op = ops[i];
+            term = operands[i + 1];
+        }
+    }
+    return applyOp(sum, term, sum_op);
+}
+
+// Pick the next operator from the level's set. Keeps the original rules:
+// no operator twice in a row and no * straight after / (or / after *).
+// When the set is too small for those rules any allowed operator will do.
+template <bool UsesDivision>
+char pick_operator(const LevelDef& level, mt19937& rng, char last_op, int divisions) {
+    bool division_left = level.max_divisions < 0 || divisions < level.max_divisions;
+    char choices[PackedQuestion::MAX_OPERATORS];
+    int count = 0;
+    for (char op : level.operators) {
+        if (op == last_op) continue;
+        if (last_op == '/' && op == '*') continue;
+        if (last_op == '*' && op == '/') continue;
+        if (UsesDivision && op == '/' && !division_left) continue;
+        choices[count++] = op;
+    }
+    if (count == 0) {
+        for (char op : level.operators) {
+            if (UsesDivision && op == '/' && !division_left) continue;
+            choices[count++] = op;
+        }
+    }
+    if (count == 0) return level.operators[0];
+    return choices[uniform_int_distribution<int>(0, count - 1)(rng)];
+}
+
+// Swap a drawn divisor for one that leaves a whole, half or quarter result.
+// The dividend is the previous operand, which is the whole left side as long
+// as / follows + or - (always true unless a level's set is only * and /).
+static int pick_divisor(int dividend, int next, bool last_operator, mt19937& rng, int* retries) {
+    if (next != 0 && (dividend % next == 0 || (dividend * 4) % next == 0)) return next;
+
+    static const int clean_divisors[] = {2, 4, 5, 8, 10};
+    uniform_int_distribution<int> small(1, 10);
+    uniform_int_distribution<int> clean(0, 4);
+    do {
+        if (retries) (*retries)++;
+        if (dividend % 10 == 0 && !last_operator) {
+            next = clean_divisors[clean(rng)];
+        } else {
+            next = small(rng);
+        }
+    } while (next == dividend || (dividend % next != 0 && (dividend * 2) % next != 0 && (dividend * 4) % next != 0));
+    return next;
+}
+
+// Generator kernel: draws operands and operators straight into a packed
+// question, then builds the text and answer from the same arrays.
+// Ops works as in evaluate_terms(); UsesDivision == false drops the
+// divisor handling for levels without /.
+template <int Ops, bool UsesDivision>
+Question generate_kernel(const LevelDef& level, mt19937& rng, int count, int* retries) {
+    const int n = Ops > 0 ? Ops : count;
+    int operands[PackedQuestion::MAX_OPERATORS + 1];
+    char ops[PackedQuestion::MAX_OPERATORS];
+    uniform_int_distribution<int> operand(level.min_operand, level.max_operand);
+
+    char last_op = ' ';
+    int divisions = 0;
+    operands[0] = operand(rng);
+    for (int i = 0; i < n; ++i) {
+        char op = pick_operator<UsesDivision>(level, rng, last_op, divisions);
+        int next = operand(rng);
+        if (UsesDivision && op == '/') {
+            next = pick_divisor(operands[i], next, i == n - 1, rng, retries);
+            divisions++;
+        }
+        ops[i] = op;
+        operands[i + 1] = next;
+        last_op = op;
+    }
+
+    Question q;
+    uint64_t bits = static_cast<uint64_t>(n - 1);
+    q.expression = to_string(operands[0]);
+    bits |= static_cast<uint64_t>(operands[0]) << 10;
+    for (int i = 0; i < n; ++i) {
+        uint64_t code = ops[i] == '+' ? 0 : ops[i] == '-' ? 1 : ops[i] == '*' ? 2 : 3;
+        bits |= code << (2 + 2 * i);
+        bits |= static_cast<uint64_t>(operands[i + 1]) << (10 + 10 * (i + 1));
+        q.expression += ' ';
+        q.expression += ops[i];
+        q.expression += ' ';
+        q.expression += to_string(operands[i + 1]);
+    }
+    q.packed.bits = bits;
+    q.answer = evaluate_terms<Ops>(operands, ops, n);
+    return q;
+}
+
+// Create a random question for a level. One to three operators cover every
+// built-in level and get their own unrolled kernels; other counts use the
+// generic kernel.
+Question generate_random_question(const LevelDef& level, mt19937& rng, int* retries) {
+    int count = uniform_int_distribution<int>(level.min_operators, level.max_operators)(rng);
+    bool division = level.operators.find('/') != string::npos;
+    switch (count) {
+        case 1: return division ? generate_kernel<1, true>(level, rng, 1, retries)
+                          : generate_kernel<1, false>(level, rng, 1, retries);
+        case 2: return division ? generate_kernel<2, true>(level, rng, 2, retries)
+                          : generate_kernel<2, false>(level, rng, 2, retries);
+        case 3: return division ? generate_kernel<3, true>(level, rng, 3, retries)
+                          : generate_kernel<3, false>(level, rng, 3, retries);
+    }
+    return division ? generate_kernel<0, true>(level, rng, count, retries)
+                    : generate_kernel<0, false>(level, rng, count, retries);
+}
+
+// Draw until the question is not in the player's seen filter. Gives up
+// after MAX_FRESH_DRAWS so a level whose few possible questions were all
+// asked recently still produces one. draws reports how many it took.
+Question generate_fresh_question(const LevelDef& level, mt19937& rng, const SeenFilter& seen, int* draws) {
+    Question q;
+    int attempt = 0;
+    do {
+        q = generate_random_question(level, rng);
+        attempt++;
+    } while (attempt < MAX_FRESH_DRAWS && seen.contains(q.packed));
+    if (draws) *draws = attempt;
+    return q;
+}
+
+const char* LEVELS_FILE = "levels.txt";
+
+// Read one levels.txt line:
+//   operators min_operand max_operand min_ops max_ops max_divisions seconds questions
+// e.g. "+-*/ 1 10 1 1 -1 20 1". Everything must fit a PackedQuestion.
+bool parse_level_line(const string& line, LevelDef& out, string& error) {
+    stringstream ss(line);
+    LevelDef level;
+    if (!(ss >> level.operators >> level.min_operand >> level.max_operand >> level.min_operators >>
+          level.max_operators >> level.max_divisions >> level.time_limit >> level.questions)) {
+        error = "expected 8 fields";
+        return false;
+    }
+    string extra;
+    if (ss >> extra) {
+        error = "unexpected \"" + extra + "\"";
+        return false;
+    }
+
+    for (size_t i = 0; i < level.operators.size(); ++i) {
+        if (string("+-*/").find(level.operators[i]) == string::npos ||
+            level.operators.find(level.operators[i], i + 1) != string::npos) {
+            error = "operators must be distinct characters from +-*/";
+            return false;
+        }
+    }
+    if (level.min_operand < 0 || level.min_operand > level.max_operand || level.max_operand > PackedQuestion::MAX_OPERAND) {
+        error = "operands must be within 0.." + to_string(PackedQuestion::MAX_OPERAND);
+        return false;
+    }
+    if (level.min_operators < 1 || level.min_operators > level.max_operators || level.max_operators > PackedQuestion::MAX_OPERATORS) {
+        error = "operator count must be within 1.." + to_string(PackedQuestion::MAX_OPERATORS);
+        return false;
+    }
+    if (level.operators == "/" && level.max_divisions >= 0 && level.max_divisions < level.max_operators) {
+        error = "a division-only level needs max_divisions of at least max_ops";
+        return false;
+    }
+    if (level.time_limit <= 0 || level.questions <= 0) {
+        error = "seconds and questions must be positive";
+        return false;
+    }
+
+    out = level;
+    return true;
+}
+
+// Read the level table from levels.txt, or fall back to the built-in levels
+vector<LevelDef> load_levels() {
+    vector<LevelDef> levels = {
+        {"+-*/", 1, 10, 1, 1, -1, 20, 1},
+        {"+-*/", 10, 30, 2, 3, -1, 15, 1},
+        {"+-*/", 15, 45, 2, 3, 1, 10, 1},
+    };
+
+    ifstream file(LEVELS_FILE);
+    if (!file) return levels;
+
+    vector<LevelDef> loaded;
+    string line;
+    int line_number = 0;
+    while (getline(file, line)) {
+        line_number++;
+        string_view text = trim_spaces(line);
+        if (text.empty() || text[0] == '#') continue;
+
+        LevelDef level;
+        string error;
+        if (!parse_level_line(string(text), level, error)) {
+            cerr << LEVELS_FILE << " line " << line_number << ": " << error << ", using built-in levels\n";
+            return levels;
+        }
+        loaded.push_back(level);
+    }
+
+    return loaded.empty() ? levels : loaded;
+}
@@ -0,0 +1,129 @@
+// The expression engine: packed questions, the level table, question
+// generation, evaluation and answer grading. Nothing in here touches SFML
+// or the player table, so the game and MathClashVerify.exe share it.
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A question squeezed into 8 bytes: operator count, up to 4 operators
+// (2 bits each) and up to 5 operands (10 bits each). The expression text
+// and answer are rebuilt from these fields only when they need to be shown.
+//   bits 0-1   operator count - 1
+//   bits 2-9   operators, 2 bits each (+ - * /)
+//   bits 10-59 operands, 10 bits each
+struct PackedQuestion {
+    static const int MAX_OPERATORS = 4;
+    static const int MAX_OPERAND = 1023;
+
+    uint64_t bits = 0;
+
+    int operator_count() const { return static_cast<int>(bits & 0x3) + 1; }
+    int operand(int i) const { return static_cast<int>((bits >> (10 + 10 * i)) & 0x3FF); }
+    char op(int i) const { return "+-*/"[(bits >> (2 + 2 * i)) & 0x3]; }
+};
+
+// Fingerprints of a player's recently asked questions: a Bloom filter kept
+// as two generations. Questions go into the current generation; once it
+// holds GENERATION_SIZE of them it becomes the previous one and a fresh one
+// starts, so the last 64 to 128 questions are remembered in 256 bytes.
+struct SeenFilter {
+    static const int BITS = 1024;   // per generation
+    static const int WORDS = BITS / 64;
+    static const int PROBES = 4;
+    static const uint32_t GENERATION_SIZE = 64;
+
+    std::vector<uint64_t> words;         // current generation, then previous; empty until first use
+    uint32_t current_count = 0;     // questions added to the current generation
+
+    bool empty() const { return words.empty(); }
+
+    // The probes are four 10-bit slices of one mixed hash of the packed bits
+    static uint64_t mix(uint64_t x) {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    bool contains(PackedQuestion q) const {
+        if (words.empty()) return false;
+        uint64_t h = mix(q.bits);
+        bool in_current = true;
+        bool in_previous = true;
+        for (int i = 0; i < PROBES; ++i) {
+            uint32_t bit = static_cast<uint32_t>(h >> (10 * i)) & (BITS - 1);
+            uint64_t mask = 1ULL << (bit & 63);
+            in_current = in_current && (words[bit >> 6] & mask);
+            in_previous = in_previous && (words[WORDS + (bit >> 6)] & mask);
+        }
+        return in_current || in_previous;
+    }
+
+    void insert(PackedQuestion q) {
+        if (words.empty()) words.assign(2 * WORDS, 0);
+        if (current_count >= GENERATION_SIZE) {
+            std::copy(words.begin(), words.begin() + WORDS, words.begin() + WORDS);
+            std::fill(words.begin(), words.begin() + WORDS, 0);
+            current_count = 0;
+        }
+        uint64_t h = mix(q.bits);
+        for (int i = 0; i < PROBES; ++i) {
+            uint32_t bit = static_cast<uint32_t>(h >> (10 * i)) & (BITS - 1);
+            words[bit >> 6] |= 1ULL << (bit & 63);
+        }
+        current_count++;
+    }
+};
+
+struct Question {
+    std::string expression;
+    double answer;
+    PackedQuestion packed;
+    bool answered_correctly = false;
+    bool skipped = false;
+};
+
+// One row of the level table. The table comes from levels.txt when it
+// exists, otherwise the built-in levels in load_levels() are used.
+struct LevelDef {
+    std::string operators = "+-*/";   // operators questions may use, each at most once
+    int min_operand = 1;
+    int max_operand = 10;
+    int min_operators = 1;       // operators per question, picked uniformly
+    int max_operators = 1;
+    int max_divisions = -1;      // divisions per question, -1 for no limit
+    int time_limit = 20;         // seconds per question
+    int questions = 1;           // questions asked before the level ends
+};
+
+// An exact fraction num/den, always reduced with den > 0
+struct Rational {
+    int64_t num = 0;
+    int64_t den = 1;
+};
+
+double evaluate_expression(const std::string& expr);
+bool pack_expression(const std::string& expr, PackedQuestion& out);
+Question materialize_question(PackedQuestion packed);
+
+bool make_rational(__int128 num, __int128 den, Rational& out);
+bool evaluate_exact(PackedQuestion q, Rational& out);
+std::string_view trim_spaces(std::string_view text);
+bool parse_answer(std::string_view input, Rational& out, int& decimals);
+bool is_answer_correct(std::string_view user_input, PackedQuestion question);
+
+// retries, when given, counts divisors that had to be re-drawn
+Question generate_random_question(const LevelDef& level, std::mt19937& rng, int* retries = nullptr);
+
+const int MAX_FRESH_DRAWS = 16;
+Question generate_fresh_question(const LevelDef& level, std::mt19937& rng, const SeenFilter& seen,
+                                 int* draws = nullptr);
+
+extern const char* LEVELS_FILE;
+bool parse_level_line(const std::string& line, LevelDef& out, std::string& error);
+std::vector<LevelDef> load_levels();
@@ -0,0 +1,120 @@
+// Command line viewer for the stats the game publishes in shared memory.
+// Reads are plain memory loads; no files are opened and users.txt is never parsed.
+//
+//   MathClashStats              top players
+//   MathClashStats <username>   one player's counters
+//   MathClashStats --all        every exported player
+//   MathClashStats --watch      top players, refreshed every second
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <thread>
+
+#include "stats_shm.h"
+
+using namespace std;
+
+struct PlayerCounters {
+    string username;
+    int total_score;
+    int games_played;
+    int games_won;
+    int games_lost;
+    unsigned failed_count;
+};
+
+bool read_player(const StatsPlayer& player, PlayerCounters& c) {
+    return stats_read_consistent(player.seq, [&]() {
+        c.username = player.username.load();
+        c.total_score = player.total_score.load(memory_order_relaxed);
+        c.games_played = player.games_played.load(memory_order_relaxed);
+        c.games_won = player.games_won.load(memory_order_relaxed);
+        c.games_lost = player.games_lost.load(memory_order_relaxed);
+        c.failed_count = player.failed_count.load(memory_order_relaxed);
+    });
+}
+
+// A record whose counter stays odd was being written when the game stopped
+int report_stuck_record() {
+    cerr << "The stats segment has a record stuck mid-write; restart Math Clash to rebuild it\n";
+    return 1;
+}
+
+void print_player(const PlayerCounters& c) {
+    cout << left << setw(20) << c.username << right
+         << " score " << setw(6) << c.total_score
+         << " | played " << setw(4) << c.games_played
+         << " won " << setw(4) << c.games_won
+         << " lost " << setw(4) << c.games_lost
+         << " | failed questions " << c.failed_count << "\n";
+}
+
+bool print_top(const StatsSegment* segment) {
+    string names[STATS_TOP_N];
+    int scores[STATS_TOP_N];
+    uint32_t count = 0;
+    bool ok = stats_read_consistent(segment->top_seq, [&]() {
+        count = min(segment->top_count.load(memory_order_relaxed), STATS_TOP_N);
+        for (uint32_t i = 0; i < count; ++i) {
+            names[i] = segment->top[i].username.load();
+            scores[i] = segment->top[i].score.load(memory_order_relaxed);
+        }
+    });
+    if (!ok) return false;
+
+    cout << "LEADERBOARD (" << segment->player_count.load() << " players)\n";
+    for (uint32_t i = 0; i < count; ++i) {
+        cout << setw(2) << i + 1 << ". " << left << setw(20) << names[i] << right << " " << scores[i] << " pts\n";
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    const StatsSegment* segment = stats_open_segment();
+    if (!segment || segment->magic != STATS_MAGIC || segment->version != STATS_VERSION) {
+        cerr << "Math Clash is not running (no stats segment found)\n";
+        return 1;
+    }
+
+    string arg = argc >= 2 ? argv[1] : "";
+    if (arg == "--watch") {
+        while (true) {
+            cout << "\033[2J\033[H";
+            if (!print_top(segment)) return report_stuck_record();
+            this_thread::sleep_for(chrono::seconds(1));
+        }
+    } else if (arg == "--all") {
+        uint32_t count = min(segment->player_count.load(memory_order_acquire), segment->capacity);
+        for (uint32_t i = 0; i < count; ++i) {
+            PlayerCounters c;
+            if (!read_player(segment->players[i], c)) return report_stuck_record();
+            print_player(c);
+        }
+    } else if (arg.size() > STATS_NAME_BYTES) {
+        cerr << "Usernames longer than " << STATS_NAME_BYTES << " characters are not exported\n";
+        stats_close_segment(segment, false);
+        return 1;
+    } else if (!arg.empty()) {
+        uint32_t count = min(segment->player_count.load(memory_order_acquire), segment->capacity);
+        bool found = false;
+        for (uint32_t i = 0; i < count && !found; ++i) {
+            PlayerCounters c;
+            if (!read_player(segment->players[i], c)) return report_stuck_record();
+            if (c.username == arg) {
+                print_player(c);
+                found = true;
+            }
+        }
+        if (!found) {
+            cerr << "No player named " << arg << "\n";
+            stats_close_segment(segment, false);
+            return 1;
+        }
+    } else if (!print_top(segment)) {
+        return report_stuck_record();
+    }
+
+    stats_close_segment(segment, false);
+    return 0;
+}
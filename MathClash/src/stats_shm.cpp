@@ -0,0 +1,64 @@
+// Platform code for mapping the shared stats segment
+#include "stats_shm.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+static const char* STATS_SEGMENT_NAME = "Local\\MathClashStats";
+static HANDLE stats_mapping = nullptr;
+
+StatsSegment* stats_create_segment() {
+    stats_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0,
+                                       sizeof(StatsSegment), STATS_SEGMENT_NAME);
+    if (!stats_mapping) return nullptr;
+    void* view = MapViewOfFile(stats_mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(StatsSegment));
+    return static_cast<StatsSegment*>(view);
+}
+
+const StatsSegment* stats_open_segment() {
+    stats_mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, STATS_SEGMENT_NAME);
+    if (!stats_mapping) return nullptr;
+    void* view = MapViewOfFile(stats_mapping, FILE_MAP_READ, 0, 0, sizeof(StatsSegment));
+    return static_cast<const StatsSegment*>(view);
+}
+
+void stats_close_segment(const StatsSegment* segment, bool) {
+    if (segment) UnmapViewOfFile(segment);
+    if (stats_mapping) CloseHandle(stats_mapping);
+    stats_mapping = nullptr;
+}
+
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static const char* STATS_SEGMENT_NAME = "/mathclash_stats";
+
+StatsSegment* stats_create_segment() {
+    int fd = shm_open(STATS_SEGMENT_NAME, O_CREAT | O_RDWR, 0644);
+    if (fd < 0) return nullptr;
+    if (ftruncate(fd, sizeof(StatsSegment)) != 0) {
+        close(fd);
+        return nullptr;
+    }
+    void* view = mmap(nullptr, sizeof(StatsSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return view == MAP_FAILED ? nullptr : static_cast<StatsSegment*>(view);
+}
+
+const StatsSegment* stats_open_segment() {
+    int fd = shm_open(STATS_SEGMENT_NAME, O_RDONLY, 0);
+    if (fd < 0) return nullptr;
+    void* view = mmap(nullptr, sizeof(StatsSegment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return view == MAP_FAILED ? nullptr : static_cast<const StatsSegment*>(view);
+}
+
+void stats_close_segment(const StatsSegment* segment, bool remove_name) {
+    if (segment) munmap(const_cast<StatsSegment*>(segment), sizeof(StatsSegment));
+    if (remove_name) shm_unlink(STATS_SEGMENT_NAME);
+}
+#endif
@@ -0,0 +1,112 @@
+// Shared-memory layout the game publishes its leaderboard and player
+// counters into. External tools map it read-only (see stats_reader.cpp)
+// and never touch users.txt.
+//
+// Every record is guarded by its own sequence counter (a seqlock): the game
+// makes it odd before writing and even again afterwards, and a reader
+// retries whenever the counter was odd or changed while it was copying.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+
+const uint32_t STATS_MAGIC = 0x5453434D;  // "MCST"
+const uint32_t STATS_VERSION = 1;
+const uint32_t STATS_TOP_N = 5;
+const uint32_t STATS_MAX_PLAYERS = 65536;
+const uint32_t STATS_NAME_WORDS = 4;
+const uint32_t STATS_NAME_BYTES = STATS_NAME_WORDS * 8;   // NUL-padded unless the name fills it
+const int STATS_READ_ATTEMPTS = 100000;
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "seqlock needs lock-free atomics");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "seqlock needs lock-free atomics");
+
+// Names are stored as atomic words so seqlock readers never race on plain memory
+struct StatsName {
+    std::atomic<uint64_t> words[STATS_NAME_WORDS];
+
+    void store(const char* text, size_t length) {
+        char buffer[STATS_NAME_BYTES] = {};
+        memcpy(buffer, text, std::min<size_t>(length, STATS_NAME_BYTES));
+        for (uint32_t i = 0; i < STATS_NAME_WORDS; ++i) {
+            uint64_t word;
+            memcpy(&word, buffer + i * sizeof(word), sizeof(word));
+            words[i].store(word, std::memory_order_relaxed);
+        }
+    }
+
+    std::string load() const {
+        char buffer[STATS_NAME_BYTES];
+        for (uint32_t i = 0; i < STATS_NAME_WORDS; ++i) {
+            uint64_t word = words[i].load(std::memory_order_relaxed);
+            memcpy(buffer + i * sizeof(word), &word, sizeof(word));
+        }
+        return std::string(buffer, strnlen(buffer, STATS_NAME_BYTES));
+    }
+};
+
+struct StatsPlayer {
+    std::atomic<uint32_t> seq;
+    StatsName username;
+    std::atomic<int32_t> total_score;
+    std::atomic<int32_t> games_played;
+    std::atomic<int32_t> games_won;
+    std::atomic<int32_t> games_lost;
+    std::atomic<uint32_t> failed_count;
+};
+
+struct StatsLeader {
+    StatsName username;
+    std::atomic<int32_t> score;
+};
+
+struct StatsSegment {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    std::atomic<uint32_t> player_count;   // players beyond capacity are not exported
+
+    std::atomic<uint32_t> top_seq;
+    std::atomic<uint32_t> top_count;
+    StatsLeader top[STATS_TOP_N];
+
+    StatsPlayer players[STATS_MAX_PLAYERS];
+};
+
+// Writer side of a seqlock; only the game's main thread writes
+inline void stats_write_begin(std::atomic<uint32_t>& seq) {
+    seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+inline void stats_write_end(std::atomic<uint32_t>& seq) {
+    seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+// Reader side: call read() until it ran without a writer in the middle.
+// Returns false after STATS_READ_ATTEMPTS tries, e.g. when a game that
+// crashed mid-write left the counter odd.
+template <typename Read>
+bool stats_read_consistent(const std::atomic<uint32_t>& seq, Read read) {
+    for (int attempt = 0; attempt < STATS_READ_ATTEMPTS; ++attempt) {
+        uint32_t before = seq.load(std::memory_order_acquire);
+        if (before & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        read();
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq.load(std::memory_order_relaxed) == before) return true;
+    }
+    return false;
+}
+
+// Create (game) or open read-only (tools) the named segment.
+// Both return nullptr on failure.
+StatsSegment* stats_create_segment();
+const StatsSegment* stats_open_segment();
+void stats_close_segment(const StatsSegment* segment, bool remove_name);
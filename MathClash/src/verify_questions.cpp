@@ -0,0 +1,259 @@
+// MathClashVerify: generates questions for every level on all cores and
+// checks each one against the exact Rational evaluator, then prints
+// answer statistics and throughput.
+//
+//   MathClashVerify.exe [questions per level] [threads] [seed]
+//
+// Levels come from levels.txt in the current directory, as in the game.
+// A final "fuzz" pass feeds random packed questions straight to the
+// evaluators. The exit code is 1 if any check failed.
+#include "questions.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+const size_t MAX_EXAMPLES = 5;
+
+struct VerifyStats {
+    uint64_t questions = 0;
+    uint64_t integer_answers = 0;
+    uint64_t terminating = 0;           // answer has a finite decimal expansion
+    uint64_t retries = 0;               // divisors the generator re-drew
+    int max_retries = 0;
+    double min_answer = INFINITY;
+    double max_answer = -INFINITY;
+    uint64_t operator_counts[PackedQuestion::MAX_OPERATORS + 1] = {};
+    uint64_t operator_uses[4] = {};     // + - * /
+
+    uint64_t exact_failed = 0;          // division by zero or 64-bit overflow
+    uint64_t evaluator_mismatch = 0;    // evaluate_expression() vs exact value
+    uint64_t kernel_mismatch = 0;       // generator's answer vs evaluate_expression()
+    uint64_t round_trip_mismatch = 0;   // packed bits do not rebuild the same text
+    uint64_t level_violations = 0;      // operands, operator count or division cap
+    uint64_t grading_failures = 0;      // a correct typed answer was rejected
+    vector<string> examples;
+
+    uint64_t failures() const {
+        return evaluator_mismatch + kernel_mismatch + round_trip_mismatch + level_violations + grading_failures;
+    }
+
+    void fail(uint64_t& counter, const string& what, const string& expression) {
+        counter++;
+        if (examples.size() < MAX_EXAMPLES) examples.push_back(what + ": " + expression);
+    }
+
+    void merge(const VerifyStats& other) {
+        questions += other.questions;
+        integer_answers += other.integer_answers;
+        terminating += other.terminating;
+        retries += other.retries;
+        max_retries = max(max_retries, other.max_retries);
+        min_answer = min(min_answer, other.min_answer);
+        max_answer = max(max_answer, other.max_answer);
+        for (int i = 0; i <= PackedQuestion::MAX_OPERATORS; ++i) operator_counts[i] += other.operator_counts[i];
+        for (int i = 0; i < 4; ++i) operator_uses[i] += other.operator_uses[i];
+        exact_failed += other.exact_failed;
+        evaluator_mismatch += other.evaluator_mismatch;
+        kernel_mismatch += other.kernel_mismatch;
+        round_trip_mismatch += other.round_trip_mismatch;
+        level_violations += other.level_violations;
+        grading_failures += other.grading_failures;
+        for (const auto& example : other.examples) {
+            if (examples.size() < MAX_EXAMPLES) examples.push_back(example);
+        }
+    }
+};
+
+// Write value exactly as a decimal; fails when the expansion does not end
+// within the 18 digits parse_answer() accepts
+bool exact_decimal(Rational value, string& out) {
+    int64_t den = value.den;
+    int twos = 0, fives = 0;
+    while (den % 2 == 0) { den /= 2; twos++; }
+    while (den % 5 == 0) { den /= 5; fives++; }
+    int digits = max(twos, fives);
+    if (den != 1 || digits > 18) return false;
+
+    __int128 scaled = value.num;
+    for (int i = 0; i < digits; ++i) scaled *= 10;
+    scaled /= value.den;
+
+    bool negative = scaled < 0;
+    if (negative) scaled = -scaled;
+    string text;
+    do {
+        text.insert(text.begin(), static_cast<char>('0' + static_cast<int>(scaled % 10)));
+        scaled /= 10;
+    } while (scaled > 0 || static_cast<int>(text.size()) <= digits);
+    if (digits > 0) text.insert(text.end() - digits, '.');
+    out = (negative ? "-" : "") + text;
+    return true;
+}
+
+// Every check that does not depend on how the question was made.
+// check_display also grades the 6-decimal text the retry screen shows when
+// that text is right: the answer has no finite decimal (so it is rounded) or
+// needs at most 6 places. A double cannot hold that many exact decimals past
+// about 1e8, so the fuzz pass (answers up to 1e15) leaves it out.
+void check_question(const Question& q, VerifyStats& stats, bool check_display) {
+    stats.questions++;
+    int count = q.packed.operator_count();
+    stats.operator_counts[count]++;
+    for (int i = 0; i < count; ++i) stats.operator_uses[string("+-*/").find(q.packed.op(i))]++;
+
+    if (materialize_question(q.packed).expression != q.expression) {
+        stats.fail(stats.round_trip_mismatch, "round trip", q.expression);
+    }
+
+    Rational exact;
+    if (!evaluate_exact(q.packed, exact)) {
+        stats.exact_failed++;
+        return;
+    }
+    double value = static_cast<double>(exact.num) / exact.den;
+    stats.min_answer = min(stats.min_answer, value);
+    stats.max_answer = max(stats.max_answer, value);
+    if (exact.den == 1) stats.integer_answers++;
+
+    double evaluated = evaluate_expression(q.expression);
+    if (fabs(evaluated - value) > 1e-9 * max(1.0, fabs(value))) {
+        stats.fail(stats.evaluator_mismatch, "evaluate_expression " + to_string(evaluated), q.expression);
+    }
+    if (q.answer != evaluated) {
+        stats.fail(stats.kernel_mismatch, "generator answer " + to_string(q.answer), q.expression);
+    }
+
+    // The exact fraction and exact decimal must always be accepted
+    string decimal;
+    bool terminating = exact_decimal(exact, decimal);
+    stats.terminating += terminating;
+    size_t dot = decimal.find('.');
+    bool display_exact = !terminating || dot == string::npos || decimal.size() - dot - 1 <= 6;
+    if (!is_answer_correct(to_string(exact.num) + "/" + to_string(exact.den), q.packed) ||
+        (terminating && !is_answer_correct(decimal, q.packed)) ||
+        (check_display && display_exact && !is_answer_correct(to_string(q.answer), q.packed))) {
+        stats.fail(stats.grading_failures, "grading", q.expression);
+    }
+}
+
+// Generated questions must also respect their level's settings. Divisors
+// may be swapped for 1-10 to keep the result clean.
+void check_level_rules(const Question& q, const LevelDef& level, VerifyStats& stats) {
+    int count = q.packed.operator_count();
+    int divisions = 0;
+    bool ok = count >= level.min_operators && count <= level.max_operators;
+    for (int i = 0; i <= count && ok; ++i) {
+        int operand = q.packed.operand(i);
+        bool divisor = i > 0 && q.packed.op(i - 1) == '/';
+        if (i < count) {
+            ok = level.operators.find(q.packed.op(i)) != string::npos;
+            divisions += q.packed.op(i) == '/';
+        }
+        if (divisor) {
+            ok = ok && operand >= 1 && operand <= max(level.max_operand, 10);
+        } else {
+            ok = ok && operand >= level.min_operand && operand <= level.max_operand;
+        }
+    }
+    if (level.max_divisions >= 0 && divisions > level.max_divisions) ok = false;
+    if (!ok) stats.fail(stats.level_violations, "level rules", q.expression);
+}
+
+// Split count questions over threads; work(thread, first, last, stats)
+template <typename Work>
+VerifyStats run_parallel(uint64_t count, unsigned threads, Work work) {
+    vector<VerifyStats> partial(threads);
+    vector<thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        uint64_t first = count * t / threads;
+        uint64_t last = count * (t + 1) / threads;
+        workers.emplace_back([&, t, first, last] { work(t, first, last, partial[t]); });
+    }
+    for (auto& worker : workers) worker.join();
+
+    VerifyStats total;
+    for (const auto& stats : partial) total.merge(stats);
+    return total;
+}
+
+void report(const string& name, const VerifyStats& stats, double seconds, unsigned threads) {
+    printf("%s: %llu questions in %.2f s (%.2f M/s on %u threads)\n", name.c_str(),
+           static_cast<unsigned long long>(stats.questions), seconds, stats.questions / seconds / 1e6, threads);
+    if (stats.questions == 0) return;
+
+    double n = static_cast<double>(stats.questions);
+    printf("  answers %g .. %g, %.2f%% whole, %.4f%% exact decimals\n", stats.min_answer, stats.max_answer,
+           100.0 * stats.integer_answers / n, 100.0 * stats.terminating / n);
+    printf("  divisor retries %.4f per question (max %d in one question)\n", stats.retries / n, stats.max_retries);
+    printf("  operators per question:");
+    for (int i = 1; i <= PackedQuestion::MAX_OPERATORS; ++i) {
+        if (stats.operator_counts[i]) printf(" %d: %.1f%%", i, 100.0 * stats.operator_counts[i] / n);
+    }
+    uint64_t uses = stats.operator_uses[0] + stats.operator_uses[1] + stats.operator_uses[2] + stats.operator_uses[3];
+    printf(" | + %.1f%% - %.1f%% * %.1f%% / %.1f%%\n", 100.0 * stats.operator_uses[0] / uses,
+           100.0 * stats.operator_uses[1] / uses, 100.0 * stats.operator_uses[2] / uses,
+           100.0 * stats.operator_uses[3] / uses);
+    printf("  failures: evaluator %llu, generator answer %llu, round trip %llu, level rules %llu, grading %llu"
+           " (not exactly evaluable: %llu)\n",
+           static_cast<unsigned long long>(stats.evaluator_mismatch), static_cast<unsigned long long>(stats.kernel_mismatch),
+           static_cast<unsigned long long>(stats.round_trip_mismatch), static_cast<unsigned long long>(stats.level_violations),
+           static_cast<unsigned long long>(stats.grading_failures), static_cast<unsigned long long>(stats.exact_failed));
+    for (const auto& example : stats.examples) printf("    %s\n", example.c_str());
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t per_level = argc >= 2 ? stoull(argv[1]) : 1000000;
+    unsigned threads = argc >= 3 ? static_cast<unsigned>(stoul(argv[2])) : max(1u, thread::hardware_concurrency());
+    uint32_t seed = argc >= 4 ? static_cast<uint32_t>(stoul(argv[3])) : 12345;
+    if (per_level == 0 || threads == 0) {
+        cerr << "Usage: MathClashVerify [questions per level] [threads] [seed]\n";
+        return 2;
+    }
+
+    vector<LevelDef> levels = load_levels();
+    using Clock = chrono::steady_clock;
+    VerifyStats overall;
+    auto overall_start = Clock::now();
+
+    for (size_t l = 0; l < levels.size(); ++l) {
+        const LevelDef& level = levels[l];
+        auto start = Clock::now();
+        VerifyStats stats = run_parallel(per_level, threads, [&](unsigned t, uint64_t first, uint64_t last, VerifyStats& out) {
+            mt19937 rng(seed ^ static_cast<uint32_t>(l * 0x9E3779B9u) ^ (t * 0x85EBCA6Bu));
+            for (uint64_t i = first; i < last; ++i) {
+                int retries = 0;
+                Question q = generate_random_question(level, rng, &retries);
+                out.retries += retries;
+                out.max_retries = max(out.max_retries, retries);
+                check_question(q, out, true);
+                check_level_rules(q, level, out);
+            }
+        });
+        report("Level " + to_string(l + 1), stats, chrono::duration<double>(Clock::now() - start).count(), threads);
+        overall.merge(stats);
+    }
+
+    // Random operands 0-1023 and operators, bypassing the generator's rules
+    auto start = Clock::now();
+    VerifyStats fuzz = run_parallel(per_level, threads, [&](unsigned t, uint64_t first, uint64_t last, VerifyStats& out) {
+        mt19937_64 rng(seed + 0x632BE59BD9B4E019ULL * (t + 1));
+        for (uint64_t i = first; i < last; ++i) {
+            PackedQuestion packed{rng() & ((1ULL << 60) - 1)};
+            check_question(materialize_question(packed), out, false);
+        }
+    });
+    report("Fuzz", fuzz, chrono::duration<double>(Clock::now() - start).count(), threads);
+    overall.merge(fuzz);
+
+    double seconds = chrono::duration<double>(Clock::now() - overall_start).count();
+    printf("Total: %llu questions, %.2f M/s, %llu failures\n", static_cast<unsigned long long>(overall.questions),
+           overall.questions / seconds / 1e6, static_cast<unsigned long long>(overall.failures()));
+    return overall.failures() == 0 ? 0 : 1;
+}